@@ -0,0 +1,331 @@
+#include "HelloTriangleApplication.h"
+
+//场景规模基准测试：按物体数量、每个物体的三角形数量和分辨率的所有组合，逐个以离屏模式运行渲染器，
+//把每次运行的帧率、录制时间、上传时间和内存占用写入结果文件，用来跟踪不同版本之间的扩展性和性能回退。
+//没有显卡的机器上可以通过VK_ICD_FILENAMES(新版加载器为VK_DRIVER_FILES)指定lavapipe或SwiftShader等软件驱动。
+
+struct BenchmarkConfig
+{
+    std::vector<uint32_t> objectCounts = { 1, 100, 1000 };
+    std::vector<uint32_t> triangleCounts = { 2, 512, 8192 };
+    std::vector<VkExtent2D> resolutions = { { 800, 600 }, { 1920, 1080 } };
+    uint32_t frameCount = 300;
+    uint32_t threadCount = 0;
+    //指定物理设备，格式和渲染器的--device相同
+    std::string device;
+    uint32_t framesInFlight = 2;
+    bool instanced = true;
+    bool gpuCulling = false;
+    bool bindless = false;
+    bool pushConstants = true;
+    bool depthPrepass = false;
+    bool frontToBack = true;
+    //所有运行都使用这个网格文件，设置后忽略triangleCounts
+    std::string meshFile;
+    bool quantizeVertices = false;
+    //所有物体使用这个流式加载的纹理，需要无绑定模式
+    std::string textureFile;
+    uint32_t textureBudgetMB = 64;
+    std::string pipelineCacheFile = "pipeline_cache.bin";
+    std::string jsonFile = "benchmark_results.json";
+    std::string csvFile;
+
+    static BenchmarkConfig parse(int argc, char** argv)
+    {
+        BenchmarkConfig config;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error("missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--objects") config.objectCounts = parseList(value());
+            else if (arg == "--triangles") config.triangleCounts = parseList(value());
+            else if (arg == "--resolutions") config.resolutions = parseResolutions(value());
+            else if (arg == "--frames") config.frameCount = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--threads") config.threadCount = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--device") config.device = value();
+            else if (arg == "--frames-in-flight") config.framesInFlight = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--no-instancing") config.instanced = false;
+            else if (arg == "--gpu-culling") config.gpuCulling = true;
+            else if (arg == "--bindless") config.bindless = true;
+            else if (arg == "--no-push-constants") config.pushConstants = false;
+            else if (arg == "--depth-prepass") config.depthPrepass = true;
+            else if (arg == "--no-front-to-back") config.frontToBack = false;
+            else if (arg == "--mesh") config.meshFile = value();
+            else if (arg == "--quantize-vertices") config.quantizeVertices = true;
+            else if (arg == "--texture") config.textureFile = value();
+            else if (arg == "--texture-budget") config.textureBudgetMB = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--pipeline-cache") config.pipelineCacheFile = value();
+            else if (arg == "--no-pipeline-cache") config.pipelineCacheFile.clear();
+            else if (arg == "--output") config.jsonFile = value();
+            else if (arg == "--csv") config.csvFile = value();
+            else throw std::runtime_error("unknown argument: " + arg);
+        }
+        if (!config.textureFile.empty())
+        {
+            config.bindless = true;
+        }
+        if (config.framesInFlight < 1 || config.framesInFlight > MAX_FRAMES_IN_FLIGHT)
+        {
+            throw std::runtime_error("--frames-in-flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+        }
+        return config;
+    }
+
+    //逗号分隔的列表，例如 1,100,1000
+    static std::vector<std::string> split(const std::string& text)
+    {
+        std::vector<std::string> items;
+        size_t start = 0;
+        while (start <= text.size())
+        {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos)
+            {
+                end = text.size();
+            }
+            if (end > start)
+            {
+                items.push_back(text.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+        return items;
+    }
+
+    static std::vector<uint32_t> parseList(const std::string& text)
+    {
+        std::vector<uint32_t> values;
+        for (const auto& item : split(text))
+        {
+            values.push_back(static_cast<uint32_t>(std::stoul(item)));
+        }
+        return values;
+    }
+
+    //例如 800x600,1920x1080
+    static std::vector<VkExtent2D> parseResolutions(const std::string& text)
+    {
+        std::vector<VkExtent2D> values;
+        for (const auto& item : split(text))
+        {
+            size_t x = item.find('x');
+            if (x == std::string::npos)
+            {
+                throw std::runtime_error("invalid resolution: " + item);
+            }
+            values.push_back({ static_cast<uint32_t>(std::stoul(item.substr(0, x))),
+                static_cast<uint32_t>(std::stoul(item.substr(x + 1))) });
+        }
+        return values;
+    }
+};
+
+//一次运行的结果，运行失败时error不为空
+struct BenchmarkResult
+{
+    uint32_t objectCount;
+    uint32_t trianglesPerObject;
+    VkExtent2D resolution;
+    RunStats stats;
+    std::string error;
+};
+
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+static bool writeJson(const std::string& path, const std::vector<BenchmarkResult>& results, const BenchmarkConfig& benchmark)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    auto writeStats = [&](const char* name, const RollingStats& stats) {
+        file << ", \"" << name << "\": { \"p50\": " << stats.percentile(50) << ", \"p95\": " << stats.percentile(95)
+            << ", \"p99\": " << stats.percentile(99) << ", \"max\": " << stats.max() << ", \"mean\": " << stats.mean()
+            << " }";
+    };
+
+    file << "{\n  \"instanced\": " << (benchmark.instanced || benchmark.gpuCulling ? "true" : "false")
+        << ",\n  \"gpu_culling\": " << (benchmark.gpuCulling ? "true" : "false")
+        << ",\n  \"bindless\": " << (benchmark.bindless ? "true" : "false")
+        << ",\n  \"push_constants\": " << (benchmark.pushConstants ? "true" : "false")
+        << ",\n  \"depth_prepass\": " << (benchmark.depthPrepass ? "true" : "false")
+        << ",\n  \"front_to_back\": " << (benchmark.frontToBack ? "true" : "false")
+        << ",\n  \"frames_in_flight\": " << benchmark.framesInFlight
+        << ",\n  \"texture\": \"" << escapeJson(benchmark.textureFile) << "\""
+        << ",\n  \"texture_budget_bytes\": " << static_cast<uint64_t>(benchmark.textureBudgetMB) * 1024 * 1024
+        << ",\n  \"quantized_vertices\": " << (benchmark.quantizeVertices ? "true" : "false") << ",\n  \"runs\": [\n";
+    for (size_t n = 0; n < results.size(); n++)
+    {
+        const auto& result = results[n];
+        const RunStats& stats = result.stats;
+
+        file << "    { \"objects\": " << result.objectCount << ", \"triangles_per_object\": " << result.trianglesPerObject
+            << ", \"width\": " << result.resolution.width << ", \"height\": " << result.resolution.height;
+        if (!result.error.empty())
+        {
+            file << ", \"error\": \"" << escapeJson(result.error) << "\"";
+        }
+        else
+        {
+            file << ", \"device\": \"" << escapeJson(stats.deviceName) << "\""
+                << ", \"triangles_per_frame\": " << static_cast<uint64_t>(stats.objectCount) * stats.trianglesPerObject
+                << ", \"frames\": " << stats.frames << ", \"fps\": " << stats.fps
+                << ", \"startup_ms\": " << stats.startupMs
+                << ", \"upload_bytes\": " << stats.uploadBytes << ", \"upload_submit_ms\": " << stats.uploadSubmitMs
+                << ", \"upload_complete_ms\": " << stats.uploadCompleteMs
+                << ", \"mesh_load_ms\": " << stats.meshLoadMs
+                << ", \"memory_block_bytes\": " << stats.memory.blockBytes
+                << ", \"memory_used_bytes\": " << stats.memory.usedBytes
+                << ", \"device_local_block_bytes\": " << stats.deviceLocalMemory.blockBytes
+                << ", \"device_local_used_bytes\": " << stats.deviceLocalMemory.usedBytes
+                << ", \"texture_resident_bytes\": " << stats.textureResidentBytes
+                << ", \"texture_streamed_bytes\": " << stats.textureStreamedBytes
+                << ", \"recorded_binds\": " << stats.recordedBinds << ", \"skipped_binds\": " << stats.skippedBinds;
+            writeStats("frame_cpu_ms", stats.timing.cpu);
+            writeStats("record_ms", stats.timing.phases[FrameProfiler::PhaseRecord]);
+            writeStats("gpu_ms", stats.timing.gpu);
+            writeStats("latency_ms", stats.timing.latency);
+        }
+        file << (n + 1 < results.size() ? " },\n" : " }\n");
+    }
+    file << "  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+static bool writeCsv(const std::string& path, const std::vector<BenchmarkResult>& results)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "objects,triangles_per_object,width,height,frames,fps,frame_cpu_p50_ms,frame_cpu_p99_ms,"
+        "record_mean_ms,record_p99_ms,gpu_p50_ms,upload_bytes,upload_submit_ms,upload_complete_ms,"
+        "memory_block_bytes,memory_used_bytes,device_local_used_bytes,error\n";
+    for (const auto& result : results)
+    {
+        const RunStats& stats = result.stats;
+        const RollingStats& record = stats.timing.phases[FrameProfiler::PhaseRecord];
+
+        file << result.objectCount << "," << result.trianglesPerObject << ","
+            << result.resolution.width << "," << result.resolution.height << ",";
+        if (!result.error.empty())
+        {
+            //错误信息里的逗号换成分号，保持列数不变
+            std::string error = result.error;
+            std::replace(error.begin(), error.end(), ',', ';');
+            file << ",,,,,,,,,,,,," << error << "\n";
+            continue;
+        }
+        file << stats.frames << "," << stats.fps << ","
+            << stats.timing.cpu.percentile(50) << "," << stats.timing.cpu.percentile(99) << ","
+            << record.mean() << "," << record.percentile(99) << ","
+            << stats.timing.gpu.percentile(50) << ","
+            << stats.uploadBytes << "," << stats.uploadSubmitMs << "," << stats.uploadCompleteMs << ","
+            << stats.memory.blockBytes << "," << stats.memory.usedBytes << ","
+            << stats.deviceLocalMemory.usedBytes << ",\n";
+    }
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv) {
+    try {
+        BenchmarkConfig benchmark = BenchmarkConfig::parse(argc, argv);
+        if (!benchmark.meshFile.empty())
+        {
+            //三角形数量由网格文件决定，只需要跑一遍
+            benchmark.triangleCounts = { 0 };
+        }
+
+        std::vector<BenchmarkResult> results;
+        for (const VkExtent2D& resolution : benchmark.resolutions)
+        {
+            for (uint32_t triangles : benchmark.triangleCounts)
+            {
+                for (uint32_t objects : benchmark.objectCounts)
+                {
+                    AppConfig config;
+                    config.headless = true;
+                    config.frameCount = benchmark.frameCount;
+                    config.width = resolution.width;
+                    config.height = resolution.height;
+                    config.objectCount = objects;
+                    config.trianglesPerObject = triangles;
+                    config.threadCount = benchmark.threadCount;
+                    config.device = benchmark.device;
+                    config.framesInFlight = benchmark.framesInFlight;
+                    config.instanced = benchmark.instanced || benchmark.gpuCulling;
+                    config.gpuCulling = benchmark.gpuCulling;
+                    config.bindless = benchmark.bindless;
+                    config.pushConstants = benchmark.pushConstants;
+                    config.depthPrepass = benchmark.depthPrepass;
+                    config.frontToBack = benchmark.frontToBack;
+                    config.meshFile = benchmark.meshFile;
+                    config.quantizeVertices = benchmark.quantizeVertices;
+                    config.textureFile = benchmark.textureFile;
+                    config.textureBudgetMB = benchmark.textureBudgetMB;
+                    config.pipelineCacheFile = benchmark.pipelineCacheFile;
+
+                    BenchmarkResult result;
+                    result.objectCount = objects;
+                    result.trianglesPerObject = triangles;
+                    result.resolution = resolution;
+                    printf("=== benchmark: %u objects, %u triangles/object, %ux%u ===\n",
+                        objects, triangles, resolution.width, resolution.height);
+
+                    //每次运行都创建完整的实例和设备，运行之间互不影响，一次失败不会中断整个测试；
+                    //run抛出异常之前已经释放了这次运行创建的设备和内存，失败记录在这一组配置的结果中
+                    try {
+                        HelloTriangleApplication app(config);
+                        app.run();
+                        result.stats = app.getRunStats();
+                        result.trianglesPerObject = result.stats.trianglesPerObject;
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << e.what() << std::endl;
+                        result.error = e.what();
+                    }
+                    results.push_back(result);
+                }
+            }
+        }
+
+        if (!writeJson(benchmark.jsonFile, results, benchmark))
+        {
+            throw std::runtime_error("failed to write " + benchmark.jsonFile);
+        }
+        if (!benchmark.csvFile.empty() && !writeCsv(benchmark.csvFile, results))
+        {
+            throw std::runtime_error("failed to write " + benchmark.csvFile);
+        }
+        printf("benchmark: %zu runs written to %s\n", results.size(), benchmark.jsonFile.c_str());
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
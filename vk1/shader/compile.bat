@@ -1,3 +1,12 @@
 D:\Graphic\Vulkan\Bin\glslc.exe shader_base.vert -o shader_base_v.spv
 D:\Graphic\Vulkan\Bin\glslc.exe shader_base.frag -o shader_base_f.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_base_instanced.vert -o shader_base_instanced_v.spv
+D:\Graphic\Vulkan\Bin\glslc.exe cull.comp -o cull_c.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_bindless.vert -o shader_bindless_v.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_push.vert -o shader_push_v.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_bindless.frag -o shader_bindless_f.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_depth.vert -o shader_depth_v.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_depth_instanced.vert -o shader_depth_instanced_v.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_depth_push.vert -o shader_depth_push_v.spv
+D:\Graphic\Vulkan\Bin\glslc.exe shader_depth_bindless.vert -o shader_depth_bindless_v.spv
 pause
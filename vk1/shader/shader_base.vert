@@ -6,6 +6,8 @@ layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
 
+layout(constant_id = 0) const float positionScale = 1.0;
+
 layout(binding = 0) uniform UniformBufferObject{
 	mat4 model;
 	mat4 view;
@@ -13,10 +15,10 @@ layout(binding = 0) uniform UniformBufferObject{
 } ubo;
 
 out gl_PerVertex{
-	vec4 gl_Position;
+	invariant vec4 gl_Position;
 };
 
 void main(){
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
+	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition * positionScale, 0.0, 1.0);
 	fragColor = inColor;
 }
\ No newline at end of file
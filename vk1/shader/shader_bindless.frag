@@ -0,0 +1,22 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUV;
+layout(location = 2) flat in uint fragTexture;
+layout(location = 0) out vec4 outColor;
+
+//bindless combined image sampler array, indexed by handles registered with BindlessDescriptors
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+void main()
+{
+	vec3 color = fragColor;
+	//0xFFFFFFFF is BindlessDescriptors::INVALID_HANDLE: no texture, or its first upload has not completed
+	if (fragTexture != 0xFFFFFFFFu)
+	{
+		color *= texture(textures[nonuniformEXT(fragTexture)], fragUV).rgb;
+	}
+	outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,45 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) flat out uint fragTexture;
+
+layout(constant_id = 0) const float positionScale = 1.0;
+
+//per-frame data, bound once per command buffer with a dynamic offset
+layout(set = 0, binding = 0) uniform FrameUniforms{
+	mat4 view;
+	mat4 proj;
+	uint instanceBuffer;
+	uint texture;
+} frame;
+
+//same layout as InstanceData on the CPU
+struct InstanceData{
+	mat4 model;
+	vec4 color;
+};
+
+//bindless storage buffer array, indexed by handles registered with BindlessDescriptors
+layout(set = 1, binding = 0) readonly buffer InstanceBuffer{
+	InstanceData instances[];
+} buffers[];
+
+out gl_PerVertex{
+	invariant vec4 gl_Position;
+};
+
+void main(){
+	//the handle is the same for the whole draw, gl_InstanceIndex includes firstInstance
+	InstanceData instance = buffers[frame.instanceBuffer].instances[gl_InstanceIndex];
+	gl_Position = frame.proj * frame.view * instance.model * vec4(inPosition * positionScale, 0.0, 1.0);
+	fragColor = inColor * instance.color.rgb;
+	//planar mapping of the mesh's local xy plane
+	fragUV = inPosition * positionScale + 0.5;
+	fragTexture = frame.texture;
+}
@@ -0,0 +1,22 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//depth prepass: reads only the position stream, gl_Position is computed with the same expression as in shader_base_instanced.vert
+layout(location = 0) in vec2 inPosition;
+layout(location = 2) in mat4 instanceModel;
+
+layout(constant_id = 0) const float positionScale = 1.0;
+
+layout(binding = 0) uniform UniformBufferObject{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+out gl_PerVertex{
+	invariant vec4 gl_Position;
+};
+
+void main(){
+	gl_Position = ubo.proj * ubo.view * instanceModel * vec4(inPosition * positionScale, 0.0, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+layout(constant_id = 0) const float positionScale = 1.0;
+
+//per-frame data, model is unused
+layout(binding = 0) uniform UniformBufferObject{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+//per-draw data, same layout as DrawPushConstants on the CPU
+layout(push_constant) uniform DrawConstants{
+	mat4 model;
+	vec4 color;
+} draw;
+
+out gl_PerVertex{
+	invariant vec4 gl_Position;
+};
+
+void main(){
+	gl_Position = ubo.proj * ubo.view * draw.model * vec4(inPosition * positionScale, 0.0, 1.0);
+	fragColor = inColor * draw.color.rgb;
+}
@@ -0,0 +1,232 @@
+#include "BindlessDescriptors.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+bool BindlessDescriptors::isSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &indexingFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound
+        && indexingFeatures.descriptorBindingUpdateUnusedWhilePending
+        && indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind
+        && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+        && indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+        && features.features.shaderStorageBufferArrayDynamicIndexing
+        && features.features.shaderSampledImageArrayDynamicIndexing;
+}
+
+VkPhysicalDeviceDescriptorIndexingFeatures BindlessDescriptors::requiredFeatures()
+{
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    //图像句柄可能来自逐物体的数据，同一次绘制中不同调用使用的下标不同
+    indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    return indexingFeatures;
+}
+
+void BindlessDescriptors::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t maxBuffers, uint32_t maxImages)
+{
+    this->device = device;
+
+    //UPDATE_AFTER_BIND的描述符有单独的、通常比普通描述符大得多的上限
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    bufferSlots.capacity = std::max(1u, std::min({ maxBuffers,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+        indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers }));
+    imageSlots.capacity = std::max(1u, std::min({ maxImages,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers,
+        indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+        indexingProperties.maxDescriptorSetUpdateAfterBindSamplers }));
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+    bindings[0].binding = STORAGE_BUFFER_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[0].descriptorCount = bufferSlots.capacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = SAMPLED_IMAGE_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[1].descriptorCount = imageSlots.capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    //UPDATE_UNUSED_WHILE_PENDING允许在指令缓冲执行期间写入它没有用到的元素
+    VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    std::array<VkDescriptorBindingFlags, 2> bindingFlags = { flags, flags };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create bindless descriptor set layout");
+    }
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = bufferSlots.capacity;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = imageSlots.capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create bindless descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate bindless descriptor set");
+    }
+}
+
+void BindlessDescriptors::destroy()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    //描述符集随描述符池一起释放
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    descriptorPool = VK_NULL_HANDLE;
+    descriptorSetLayout = VK_NULL_HANDLE;
+    descriptorSet = VK_NULL_HANDLE;
+    bufferSlots = SlotAllocator();
+    imageSlots = SlotAllocator();
+
+    device = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessDescriptors::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    uint32_t handle = bufferSlots.allocate();
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = STORAGE_BUFFER_BINDING;
+    write.dstArrayElement = handle;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return handle;
+}
+
+uint32_t BindlessDescriptors::addImage(VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    uint32_t handle = imageSlots.allocate();
+    writeImage(handle, imageView, sampler, layout);
+    return handle;
+}
+
+void BindlessDescriptors::updateImage(uint32_t handle, VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    writeImage(handle, imageView, sampler, layout);
+}
+
+void BindlessDescriptors::removeBuffer(uint32_t handle)
+{
+    bufferSlots.free(handle);
+}
+
+void BindlessDescriptors::removeImage(uint32_t handle)
+{
+    imageSlots.free(handle);
+}
+
+void BindlessDescriptors::writeImage(uint32_t handle, VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = sampler;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = SAMPLED_IMAGE_BINDING;
+    write.dstArrayElement = handle;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+uint32_t BindlessDescriptors::SlotAllocator::allocate()
+{
+    uint32_t slot;
+    if (!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else if (next < capacity)
+    {
+        slot = next++;
+    }
+    else
+    {
+        throw std::runtime_error("bindless descriptor array is full");
+    }
+    used++;
+    return slot;
+}
+
+void BindlessDescriptors::SlotAllocator::free(uint32_t slot)
+{
+    if (slot == INVALID_HANDLE || slot >= next || std::find(freeSlots.begin(), freeSlots.end(), slot) != freeSlots.end())
+    {
+        return;
+    }
+    freeSlots.push_back(slot);
+    used--;
+}
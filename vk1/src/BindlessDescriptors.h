@@ -0,0 +1,71 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+//无绑定的资源模型：一个描述符集里放两个很大的描述符数组，绑定0是存储缓冲，绑定1是组合图像采样器。
+//数组使用部分绑定(PARTIALLY_BOUND)，没有写入的元素只要着色器不访问就是合法的；
+//并且可以在绑定之后更新(UPDATE_AFTER_BIND)，添加资源时只写入一个元素，不需要重新分配或重新绑定描述符集。
+//资源用返回的整数句柄标识，着色器用句柄作为数组下标访问，整个描述符集每个指令缓冲只绑定一次。
+//需要Vulkan 1.2的描述符索引特性，程序选择的设备都至少是1.2，不需要启用扩展。
+class BindlessDescriptors
+{
+public:
+    //没有分配的句柄
+    static const uint32_t INVALID_HANDLE = UINT32_MAX;
+
+    //绑定号，和着色器中的set = BINDLESS_SET布局一致
+    static const uint32_t STORAGE_BUFFER_BINDING = 0;
+    static const uint32_t SAMPLED_IMAGE_BINDING = 1;
+
+    //设备是否支持需要的描述符索引特性，在创建逻辑设备之前调用
+    static bool isSupported(VkPhysicalDevice physicalDevice);
+    //创建逻辑设备时链接到VkPhysicalDeviceFeatures2的pNext
+    static VkPhysicalDeviceDescriptorIndexingFeatures requiredFeatures();
+
+    //数组大小会被限制在设备允许的范围内
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t maxBuffers, uint32_t maxImages);
+    void destroy();
+
+    //写入一个存储缓冲或者图像，返回着色器中使用的下标。
+    //绑定之后再写入只要不覆盖正在执行的指令缓冲访问的元素就是安全的
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+    uint32_t addImage(VkImageView imageView, VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    //改写已有句柄指向的资源，例如图像换成了更高的mip级别
+    void updateImage(uint32_t handle, VkImageView imageView, VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    //释放句柄，之后可以被重新分配。调用者保证正在执行的帧不再使用这个句柄
+    void removeBuffer(uint32_t handle);
+    void removeImage(uint32_t handle);
+
+    VkDescriptorSetLayout getLayout() const { return descriptorSetLayout; }
+    VkDescriptorSet getSet() const { return descriptorSet; }
+    uint32_t getBufferCount() const { return bufferSlots.used; }
+    uint32_t getImageCount() const { return imageSlots.used; }
+
+private:
+    //数组中的空闲位置，释放的下标优先被重新使用，数组保持紧凑
+    struct SlotAllocator
+    {
+        uint32_t capacity = 0;
+        uint32_t next = 0;
+        uint32_t used = 0;
+        std::vector<uint32_t> freeSlots;
+
+        uint32_t allocate();
+        //无效句柄和已经空闲的位置被忽略，重复释放不会让计数出错
+        void free(uint32_t slot);
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+    SlotAllocator bufferSlots;
+    SlotAllocator imageSlots;
+
+    void writeImage(uint32_t handle, VkImageView imageView, VkSampler sampler, VkImageLayout layout);
+};
@@ -0,0 +1,145 @@
+#include "DeviceSelector.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+std::vector<DeviceSelector::Candidate> DeviceSelector::enumerate(VkInstance instance, bool queryUuid)
+{
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+    std::vector<Candidate> candidates(deviceCount);
+    for (uint32_t i = 0; i < deviceCount; i++)
+    {
+        Candidate& candidate = candidates[i];
+        candidate.device = devices[i];
+        candidate.index = i;
+        vkGetPhysicalDeviceProperties(devices[i], &candidate.properties);
+
+        //设备UUID是1.1的核心功能，设备本身也要支持1.1
+        if (queryUuid && candidate.properties.apiVersion >= VK_API_VERSION_1_1)
+        {
+            VkPhysicalDeviceIDProperties idProperties = {};
+            idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+            VkPhysicalDeviceProperties2 properties2 = {};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties2.pNext = &idProperties;
+            vkGetPhysicalDeviceProperties2(devices[i], &properties2);
+            std::copy(idProperties.deviceUUID, idProperties.deviceUUID + VK_UUID_SIZE, candidate.uuid);
+            candidate.hasUuid = true;
+        }
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(devices[i], &memoryProperties);
+        for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++)
+        {
+            if (memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            {
+                candidate.deviceLocalBytes += memoryProperties.memoryHeaps[heap].size;
+            }
+        }
+
+        candidate.score = score(candidate);
+    }
+    return candidates;
+}
+
+void DeviceSelector::rank(std::vector<Candidate>& candidates)
+{
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.score > b.score;
+    });
+}
+
+uint64_t DeviceSelector::score(const Candidate& candidate)
+{
+    uint64_t typeRank = 0;
+    switch (candidate.properties.deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: typeRank = 4; break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: typeRank = 3; break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: typeRank = 2; break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU: typeRank = 1; break;
+    default: typeRank = 0; break;
+    }
+
+    //集成显卡的设备本地堆通常是共享的系统内存，所以类型排在内存大小之前
+    uint64_t memoryMB = std::min<uint64_t>(candidate.deviceLocalBytes / (1024 * 1024), (1ull << 40) - 1);
+
+    //只在类型和内存都相同时起作用：纹理尺寸、推送常量、计算着色器的共享内存和无绑定图像数组的上限
+    const VkPhysicalDeviceLimits& limits = candidate.properties.limits;
+    uint64_t limitsScore = limits.maxImageDimension2D / 1024
+        + limits.maxPushConstantsSize / 64
+        + limits.maxComputeSharedMemorySize / 4096
+        + limits.maxPerStageDescriptorSampledImages / 65536;
+    limitsScore = std::min<uint64_t>(limitsScore, 0xFFFF);
+
+    return (typeRank << 56) | (memoryMB << 16) | limitsScore;
+}
+
+bool DeviceSelector::matches(const Candidate& candidate, const std::string& selector)
+{
+    if (selector.empty())
+    {
+        return false;
+    }
+
+    //先按UUID匹配，全是数字的UUID也不会被当成下标
+    std::string hex;
+    for (unsigned char c : selector)
+    {
+        if (c != '-')
+        {
+            hex.push_back(static_cast<char>(std::tolower(c)));
+        }
+    }
+    if (hex.size() == VK_UUID_SIZE * 2 && std::all_of(hex.begin(), hex.end(), [](unsigned char c) { return std::isxdigit(c); }))
+    {
+        std::string uuid = formatUuid(candidate.uuid);
+        uuid.erase(std::remove(uuid.begin(), uuid.end(), '-'), uuid.end());
+        return candidate.hasUuid && uuid == hex;
+    }
+
+    //位数限制保证不会超出uint32_t的范围，stoul不会抛出异常；更长的数字按名称匹配
+    if (selector.size() <= 9 && std::all_of(selector.begin(), selector.end(), [](unsigned char c) { return std::isdigit(c); }))
+    {
+        return std::stoul(selector) == candidate.index;
+    }
+
+    auto lower = [](std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    };
+    return lower(candidate.properties.deviceName).find(lower(selector)) != std::string::npos;
+}
+
+const char* DeviceSelector::typeName(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+    default: return "other";
+    }
+}
+
+std::string DeviceSelector::formatUuid(const uint8_t uuid[VK_UUID_SIZE])
+{
+    std::string text;
+    char digits[3];
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+    {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+        {
+            text.push_back('-');
+        }
+        snprintf(digits, sizeof(digits), "%02x", uuid[i]);
+        text += digits;
+    }
+    return text;
+}
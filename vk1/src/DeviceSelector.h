@@ -0,0 +1,39 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//物理设备的排序和指定。
+//分数依次比较设备类型(独立显卡 > 集成显卡 > 虚拟GPU > CPU)、设备本地堆的总大小和几项限制，
+//多显卡的机器上默认选择分数最高的可用设备。
+//也可以用选择字符串指定设备：全是数字时是枚举顺序中的下标，32个十六进制数字(可以带'-')时是设备UUID，
+//其他情况按设备名称匹配，不区分大小写，名称中包含这个字符串即可。
+class DeviceSelector
+{
+public:
+    struct Candidate
+    {
+        VkPhysicalDevice device = VK_NULL_HANDLE;
+        uint32_t index = 0; //vkEnumeratePhysicalDevices返回的顺序
+        VkPhysicalDeviceProperties properties = {};
+        uint8_t uuid[VK_UUID_SIZE] = {};
+        bool hasUuid = false;
+        VkDeviceSize deviceLocalBytes = 0;
+        uint64_t score = 0;
+    };
+
+    //实例版本至少为1.1时才能查询设备UUID
+    static std::vector<Candidate> enumerate(VkInstance instance, bool queryUuid);
+    //按分数从高到低排序，分数相同时保持枚举顺序
+    static void rank(std::vector<Candidate>& candidates);
+    static bool matches(const Candidate& candidate, const std::string& selector);
+
+    static const char* typeName(VkPhysicalDeviceType type);
+    //xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx
+    static std::string formatUuid(const uint8_t uuid[VK_UUID_SIZE]);
+
+private:
+    static uint64_t score(const Candidate& candidate);
+};
@@ -0,0 +1,96 @@
+#include "FrameLimiter.h"
+
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+FrameLimiter::~FrameLimiter()
+{
+#ifdef _WIN32
+    if (timerPeriodRaised)
+    {
+        timeEndPeriod(1);
+    }
+#endif
+}
+
+void FrameLimiter::setTargetFps(double fps)
+{
+    interval = fps > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps))
+        : Clock::duration::zero();
+    started = false;
+
+#ifdef _WIN32
+    //默认的系统时钟粒度约15.6ms，1ms的睡眠会睡一整个时钟周期
+    if (isEnabled() && !timerPeriodRaised)
+    {
+        timerPeriodRaised = timeBeginPeriod(1) == TIMERR_NOERROR;
+    }
+#endif
+
+    if (isEnabled() && sleepCount == 1)
+    {
+        sampleSleep();
+    }
+}
+
+double FrameLimiter::wait()
+{
+    if (!isEnabled())
+    {
+        return 0.0;
+    }
+
+    Clock::time_point start = Clock::now();
+    if (!started || start - next > interval)
+    {
+        next = start;
+        started = true;
+    }
+
+    double remaining = std::chrono::duration<double, std::milli>(next - start).count();
+    if (remaining > 0.0)
+    {
+        preciseSleep(remaining);
+    }
+    next += interval;
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void FrameLimiter::preciseSleep(double ms)
+{
+    Clock::time_point target = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(ms));
+
+    while (ms > sleepEstimate)
+    {
+        ms -= sampleSleep();
+    }
+
+    while (Clock::now() < target)
+    {
+        std::this_thread::yield();
+    }
+}
+
+double FrameLimiter::sampleSleep()
+{
+    Clock::time_point start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double observed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    //Welford算法更新均值和方差
+    sleepCount++;
+    double delta = observed - sleepMean;
+    sleepMean += delta / sleepCount;
+    sleepM2 += delta * (observed - sleepMean);
+    sleepEstimate = sleepMean + std::sqrt(sleepM2 / (sleepCount - 1));
+    return observed;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+//按目标帧率限制主循环，每帧开始前调用wait。
+//系统的睡眠通常会多睡一点，并且粒度可能有1ms甚至更大，直接睡到目标时间会让帧间隔抖动；
+//这里每次只睡1ms，并用已经观察到的睡眠耗时估计一次睡眠最多会用多久(均值加一个标准差)，
+//剩余时间大于这个估计时才继续睡，最后一小段自旋等待，既准确又不会整帧空转占满一个CPU核心。
+//目标时间按固定间隔推进，偶尔的慢帧不会让之后的帧都往后推；落后超过一帧时从当前时间重新开始。
+class FrameLimiter
+{
+public:
+    ~FrameLimiter();
+
+    //fps为0时关闭限制
+    void setTargetFps(double fps);
+    bool isEnabled() const { return interval.count() > 0; }
+
+    //等到这一帧的开始时间，返回等待的毫秒数
+    double wait();
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    Clock::duration interval = Clock::duration::zero();
+    Clock::time_point next;
+    bool started = false;
+    bool timerPeriodRaised = false;
+
+    //1ms睡眠的实际耗时的统计，单位毫秒，开始时按2ms估计。
+    //估计值大于一帧的时间时永远不会睡眠，也就不会更新，所以开启限制时先睡一次取得第一个样本
+    double sleepEstimate = 2.0;
+    double sleepMean = 2.0;
+    double sleepM2 = 0.0;
+    uint64_t sleepCount = 1;
+
+    void preciseSleep(double ms);
+    //睡眠1ms并把实际耗时加入统计，返回实际耗时
+    double sampleSleep();
+};
@@ -0,0 +1,404 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+void RollingStats::add(double value)
+{
+    if (samples.size() < window)
+    {
+        samples.push_back(value);
+    }
+    else
+    {
+        samples[next] = value;
+    }
+    next = (next + 1) % window;
+}
+
+void RollingStats::clear()
+{
+    samples.clear();
+    next = 0;
+}
+
+//最近邻取整的百分位，样本数为1000时p99就是第990个
+double RollingStats::percentile(double p) const
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    std::vector<double> sorted = samples;
+    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+double RollingStats::max() const
+{
+    return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+}
+
+double RollingStats::mean() const
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    double total = 0.0;
+    for (double sample : samples)
+    {
+        total += sample;
+    }
+    return total / samples.size();
+}
+
+void FrameProfiler::init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily,
+    uint32_t framesInFlight, bool keepHistory, size_t window)
+{
+    this->device = device;
+    this->keepHistory = keepHistory;
+
+    for (auto& stats : phaseStats)
+    {
+        stats = RollingStats(window);
+    }
+    cpuStats = RollingStats(window);
+    gpuStats = RollingStats(window);
+    latencyStats = RollingStats(window);
+
+    pendingGpuFrame.assign(framesInFlight, -1);
+    gpuWritten.assign(framesInFlight, false);
+
+    //timestampValidBits为0表示这个队列族不支持时间戳
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+    if (validBits == 0)
+    {
+        printf("frame profiler: queue family %u has no timestamp support, GPU timing disabled\n", queueFamily);
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = framesInFlight * 2;
+
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create timestamp query pool");
+    }
+}
+
+void FrameProfiler::destroy()
+{
+    if (queryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device, queryPool, nullptr);
+        queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void FrameProfiler::beginFrame(uint32_t frameIndex)
+{
+    current = FrameRecord();
+    current.frame = frameNumber;
+    currentSlot = frameIndex;
+    frameStart = Clock::now();
+    lastMark = frameStart;
+}
+
+void FrameProfiler::endPhase(Phase phase)
+{
+    Clock::time_point now = Clock::now();
+    current.phases[phase] += elapsedMs(lastMark, now);
+    lastMark = now;
+}
+
+void FrameProfiler::collectGpu(uint32_t frameIndex)
+{
+    if (queryPool == VK_NULL_HANDLE || !gpuWritten[frameIndex])
+    {
+        return;
+    }
+
+    uint64_t timestamps[2] = {};
+    VkResult result = vkGetQueryPoolResults(device, queryPool, frameIndex * 2, 2, sizeof(timestamps), timestamps,
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    gpuWritten[frameIndex] = false;
+    if (result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    uint64_t ticks = ((timestamps[1] & timestampMask) - (timestamps[0] & timestampMask)) & timestampMask;
+    double gpuMs = ticks * timestampPeriod / 1e6;
+    gpuStats.add(gpuMs);
+
+    int64_t frame = pendingGpuFrame[frameIndex];
+    if (keepHistory && frame >= 0 && static_cast<size_t>(frame) < history.size())
+    {
+        history[frame].gpu = gpuMs;
+    }
+}
+
+void FrameProfiler::endFrame()
+{
+    current.cpu = elapsedMs(frameStart, Clock::now());
+
+    for (int i = 0; i < PhaseCount; i++)
+    {
+        phaseStats[i].add(current.phases[i]);
+    }
+    cpuStats.add(current.cpu);
+
+    if (gpuWritten[currentSlot])
+    {
+        pendingGpuFrame[currentSlot] = static_cast<int64_t>(current.frame);
+    }
+    if (keepHistory)
+    {
+        history.push_back(current);
+    }
+    frameNumber++;
+}
+
+void FrameProfiler::addLatency(uint64_t frame, double ms)
+{
+    latencyStats.add(ms);
+    if (keepHistory && frame < history.size())
+    {
+        history[frame].latency = ms;
+    }
+}
+
+void FrameProfiler::writeGpuBegin(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (queryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * 2, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, frameIndex * 2);
+}
+
+void FrameProfiler::writeGpuEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (queryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, frameIndex * 2 + 1);
+    gpuWritten[frameIndex] = true;
+}
+
+const char* FrameProfiler::phaseName(Phase phase)
+{
+    static const char* names[PhaseCount] = { "wait", "acquire", "update", "record", "submit", "present" };
+    return names[phase];
+}
+
+double FrameProfiler::elapsedMs(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+static void printStatsLine(const char* name, const RollingStats& stats)
+{
+    printf("  %-8s p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms\n", name,
+        stats.percentile(50), stats.percentile(95), stats.percentile(99), stats.max());
+}
+
+void FrameProfiler::printRolling() const
+{
+    printf("frame timing, last %zu frames:\n", cpuStats.count());
+    printStatsLine("cpu", cpuStats);
+    if (gpuStats.count() > 0)
+    {
+        printStatsLine("gpu", gpuStats);
+    }
+    if (latencyStats.count() > 0)
+    {
+        printStatsLine("latency", latencyStats);
+    }
+    for (int i = 0; i < PhaseCount; i++)
+    {
+        printStatsLine(phaseName(static_cast<Phase>(i)), phaseStats[i]);
+    }
+}
+
+FrameProfiler::Summary FrameProfiler::summarize() const
+{
+    Summary summary;
+    if (!keepHistory)
+    {
+        summary.cpu = cpuStats;
+        summary.gpu = gpuStats;
+        summary.latency = latencyStats;
+        for (int i = 0; i < PhaseCount; i++)
+        {
+            summary.phases[i] = phaseStats[i];
+        }
+        return summary;
+    }
+
+    //用整个历史重新统计
+    summary.cpu = RollingStats(history.size() + 1);
+    summary.gpu = RollingStats(history.size() + 1);
+    summary.latency = RollingStats(history.size() + 1);
+    for (auto& stats : summary.phases)
+    {
+        stats = RollingStats(history.size() + 1);
+    }
+    for (const auto& record : history)
+    {
+        summary.cpu.add(record.cpu);
+        if (record.gpu >= 0.0)
+        {
+            summary.gpu.add(record.gpu);
+        }
+        if (record.latency >= 0.0)
+        {
+            summary.latency.add(record.latency);
+        }
+        for (int i = 0; i < PhaseCount; i++)
+        {
+            summary.phases[i].add(record.phases[i]);
+        }
+    }
+    return summary;
+}
+
+void FrameProfiler::printSummary() const
+{
+    if (!keepHistory)
+    {
+        printRolling();
+        return;
+    }
+
+    Summary summary = summarize();
+    printf("frame timing, all %zu frames:\n", history.size());
+    printStatsLine("cpu", summary.cpu);
+    if (summary.gpu.count() > 0)
+    {
+        printStatsLine("gpu", summary.gpu);
+    }
+    if (summary.latency.count() > 0)
+    {
+        printStatsLine("latency", summary.latency);
+    }
+    for (int i = 0; i < PhaseCount; i++)
+    {
+        printStatsLine(phaseName(static_cast<Phase>(i)), summary.phases[i]);
+    }
+}
+
+bool FrameProfiler::writeCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "frame";
+    for (int i = 0; i < PhaseCount; i++)
+    {
+        file << "," << phaseName(static_cast<Phase>(i)) << "_ms";
+    }
+    file << ",cpu_ms,gpu_ms,latency_ms\n";
+
+    for (const auto& record : history)
+    {
+        file << record.frame;
+        for (int i = 0; i < PhaseCount; i++)
+        {
+            file << "," << record.phases[i];
+        }
+        file << "," << record.cpu << ",";
+        if (record.gpu >= 0.0)
+        {
+            file << record.gpu;
+        }
+        file << ",";
+        if (record.latency >= 0.0)
+        {
+            file << record.latency;
+        }
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool FrameProfiler::writeJson(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    Summary summary = summarize();
+
+    auto writeStats = [&](const char* name, const RollingStats& stats) {
+        file << "    \"" << name << "\": { \"p50\": " << stats.percentile(50) << ", \"p95\": " << stats.percentile(95)
+            << ", \"p99\": " << stats.percentile(99) << ", \"max\": " << stats.max() << ", \"mean\": " << stats.mean()
+            << " }";
+    };
+
+    file << "{\n  \"frames\": " << history.size() << ",\n  \"summary\": {\n";
+    writeStats("cpu_ms", summary.cpu);
+    file << ",\n";
+    writeStats("gpu_ms", summary.gpu);
+    file << ",\n";
+    writeStats("latency_ms", summary.latency);
+    file << "\n  },\n  \"samples\": [\n";
+
+    for (size_t n = 0; n < history.size(); n++)
+    {
+        const auto& record = history[n];
+        file << "    { \"frame\": " << record.frame;
+        for (int i = 0; i < PhaseCount; i++)
+        {
+            file << ", \"" << phaseName(static_cast<Phase>(i)) << "_ms\": " << record.phases[i];
+        }
+        file << ", \"cpu_ms\": " << record.cpu << ", \"gpu_ms\": ";
+        if (record.gpu >= 0.0)
+        {
+            file << record.gpu;
+        }
+        else
+        {
+            file << "null";
+        }
+        file << ", \"latency_ms\": ";
+        if (record.latency >= 0.0)
+        {
+            file << record.latency;
+        }
+        else
+        {
+            file << "null";
+        }
+        file << (n + 1 < history.size() ? " },\n" : " }\n");
+    }
+    file << "  ]\n}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//最近若干个样本的滚动统计，用来看帧时间的尾部(卡顿)而不只是平均值
+class RollingStats
+{
+public:
+    explicit RollingStats(size_t window = 1000) : window(window > 0 ? window : 1) {}
+
+    void add(double value);
+    void clear();
+    size_t count() const { return samples.size(); }
+
+    //p在[0, 100]之间，没有样本时返回0
+    double percentile(double p) const;
+    double max() const;
+    double mean() const;
+
+private:
+    size_t window;
+    size_t next = 0;
+    std::vector<double> samples;
+};
+
+//每帧的计时：CPU上每个阶段的耗时，加上GPU上用时间戳查询测得的耗时。
+//GPU时间戳按并行帧各用一对查询，等到这一帧上次提交的时间线值之后再读取，读取不会阻塞。
+class FrameProfiler
+{
+public:
+    enum Phase
+    {
+        PhaseWait,    //等待这一帧上次提交的时间线值
+        PhaseAcquire, //获取交换链图像
+        PhaseUpdate,  //更新uniform数据
+        PhaseRecord,  //录制指令
+        PhaseSubmit,  //提交到队列
+        PhasePresent, //呈现
+        PhaseCount
+    };
+
+    //一帧的完整记录，时间单位都是毫秒，gpu和latency为负表示没有测到
+    struct FrameRecord
+    {
+        uint64_t frame = 0;
+        double phases[PhaseCount] = {};
+        double cpu = 0.0;
+        double gpu = -1.0;
+        double latency = -1.0; //从提交到呈现(或者GPU执行完)的时间
+    };
+
+    //一组帧的统计，没有测到GPU时间或延迟时对应的统计中没有样本
+    struct Summary
+    {
+        RollingStats cpu;
+        RollingStats gpu;
+        RollingStats latency;
+        RollingStats phases[PhaseCount];
+    };
+
+    //queueFamily是提交绘制指令的队列族，它不支持时间戳时只统计CPU时间。
+    //keepHistory为true时保存每一帧的记录，用于导出CSV/JSON
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight,
+        bool keepHistory, size_t window = 1000);
+    void destroy();
+
+    //frameIndex是并行帧的索引
+    void beginFrame(uint32_t frameIndex);
+    //结束一个阶段，记录从上一个阶段结束(或帧开始)到现在的时间
+    void endPhase(Phase phase);
+    //这一帧上次提交的时间线值已经到达后调用，读取这一个并行帧上次写入的时间戳
+    void collectGpu(uint32_t frameIndex);
+    void endFrame();
+    //这一帧的帧号，在beginFrame和endFrame之间有效
+    uint64_t getFrameNumber() const { return current.frame; }
+    //延迟在之后的帧中才测到，按帧号补到记录上
+    void addLatency(uint64_t frame, double ms);
+
+    //在主指令缓冲的开头和结尾写入时间戳，开头的调用会先重置这一帧的查询，必须在渲染流程外
+    void writeGpuBegin(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    void writeGpuEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+    bool hasGpuTiming() const { return queryPool != VK_NULL_HANDLE; }
+
+    //打印最近window帧的p50/p95/p99/max
+    void printRolling() const;
+    //整个运行期间的统计，没有保存历史时使用最近window帧
+    Summary summarize() const;
+    void printSummary() const;
+
+    static const char* phaseName(Phase phase);
+
+    bool writeCsv(const std::string& path) const;
+    bool writeJson(const std::string& path) const;
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    double timestampPeriod = 1.0; //每个时间戳计数的纳秒数
+    uint64_t timestampMask = ~0ull;
+
+    bool keepHistory = false;
+    std::vector<FrameRecord> history;
+    //每个并行帧上次写入时间戳的那一帧，在history中的位置；没有写入过为-1
+    std::vector<int64_t> pendingGpuFrame;
+    std::vector<bool> gpuWritten;
+
+    FrameRecord current;
+    uint32_t currentSlot = 0;
+    uint64_t frameNumber = 0;
+    Clock::time_point frameStart;
+    Clock::time_point lastMark;
+
+    RollingStats phaseStats[PhaseCount];
+    RollingStats cpuStats;
+    RollingStats gpuStats;
+    RollingStats latencyStats;
+
+    static double elapsedMs(Clock::time_point from, Clock::time_point to);
+};
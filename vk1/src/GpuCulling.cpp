@@ -0,0 +1,329 @@
+#include "GpuCulling.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+//和cull.comp中的local_size_x一致
+static const uint32_t CULL_GROUP_SIZE = 64;
+
+bool GpuCulling::isSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    return features.multiDrawIndirect && features.drawIndirectFirstInstance;
+}
+
+bool GpuCulling::hasDrawIndirectCount(VkPhysicalDevice physicalDevice)
+{
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions)
+    {
+        if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//Gribb-Hartmann方法：裁剪空间的每个平面对应观察投影矩阵两行的和或差。
+//近平面按OpenGL的[-w, w]深度范围取，比Vulkan的[0, w]更宽，只会少剔除不会错剔除
+void GpuCulling::extractFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6])
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+    {
+        rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    }
+
+    planes[0] = rows[3] + rows[0]; //左
+    planes[1] = rows[3] - rows[0]; //右
+    planes[2] = rows[3] + rows[1]; //下
+    planes[3] = rows[3] - rows[1]; //上
+    planes[4] = rows[3] + rows[2]; //近
+    planes[5] = rows[3] - rows[2]; //远
+
+    for (int i = 0; i < 6; i++)
+    {
+        float length = glm::length(glm::vec3(planes[i]));
+        if (length > 0.0f)
+        {
+            planes[i] /= length;
+        }
+    }
+}
+
+void GpuCulling::init(VkDevice device, MemoryAllocator& allocator, VkPipelineCache pipelineCache,
+    const std::vector<char>& shaderCode, uint32_t objectCount, uint32_t framesInFlight, bool useDrawIndirectCount)
+{
+    this->device = device;
+    this->allocator = &allocator;
+    this->objectCount = std::max(1u, objectCount);
+
+    if (useDrawIndirectCount)
+    {
+        drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+
+    createBuffer(sizeof(ObjectData) * this->objectCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        objectBuffer, objectAllocation);
+
+    frames.resize(framesInFlight);
+    for (auto& frame : frames)
+    {
+        //实例数据由计算着色器写入，之后作为顶点缓冲读取，每个实例是一个mat4和一个vec4
+        createBuffer((sizeof(glm::mat4) + sizeof(glm::vec4)) * this->objectCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            frame.instanceBuffer, frame.instanceAllocation);
+        createBuffer(sizeof(VkDrawIndexedIndirectCommand) * this->objectCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            frame.commandBuffer, frame.commandAllocation);
+        createBuffer(sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            frame.countBuffer, frame.countAllocation);
+    }
+
+    createDescriptors(framesInFlight);
+    createPipeline(pipelineCache, shaderCode);
+}
+
+void GpuCulling::destroy()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+    for (auto& frame : frames)
+    {
+        destroyBuffer(frame.instanceBuffer, frame.instanceAllocation);
+        destroyBuffer(frame.commandBuffer, frame.commandAllocation);
+        destroyBuffer(frame.countBuffer, frame.countAllocation);
+    }
+    frames.clear();
+    destroyBuffer(objectBuffer, objectAllocation);
+
+    device = VK_NULL_HANDLE;
+}
+
+void GpuCulling::uploadObjects(UploadManager& uploadManager, const std::vector<ObjectData>& objects)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+
+    uploadManager.uploadBuffer(objectBuffer, 0, objects.data(), sizeof(ObjectData) * objects.size(),
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+void GpuCulling::recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex, CullParams params)
+{
+    FrameBuffers& frame = frames[frameIndex];
+    params.compact = usesDrawIndirectCount() ? 1 : 0;
+
+    //压缩模式下计算着色器用原子操作递增绘制数量，先清零
+    vkCmdFillBuffer(commandBuffer, frame.countBuffer, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier clearBarrier = {};
+    clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1,
+        &frame.descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams), &params);
+    vkCmdDispatch(commandBuffer, (params.objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+}
+
+void GpuCulling::recordDraw(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    FrameBuffers& frame = frames[frameIndex];
+
+    if (usesDrawIndirectCount())
+    {
+        drawIndexedIndirectCount(commandBuffer, frame.commandBuffer, 0, frame.countBuffer, 0, objectCount,
+            sizeof(VkDrawIndexedIndirectCommand));
+    }
+    else
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, frame.commandBuffer, 0, objectCount, sizeof(VkDrawIndexedIndirectCommand));
+    }
+}
+
+void GpuCulling::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, Allocation& allocation)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling buffer");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+    allocation = allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, AllocationType::Linear);
+    vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+}
+
+void GpuCulling::destroyBuffer(VkBuffer& buffer, Allocation& allocation)
+{
+    if (buffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator->free(allocation);
+    buffer = VK_NULL_HANDLE;
+}
+
+void GpuCulling::createDescriptors(uint32_t framesInFlight)
+{
+    //0:物体 1:实例 2:间接绘制指令 3:绘制数量
+    std::array<VkDescriptorSetLayoutBinding, 4> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling descriptor set layout");
+    }
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size()) * framesInFlight;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = framesInFlight;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling descriptor pool");
+    }
+
+    for (auto& frame : frames)
+    {
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate culling descriptor set");
+        }
+
+        VkDescriptorBufferInfo bufferInfos[4] = {
+            { objectBuffer, 0, VK_WHOLE_SIZE },
+            { frame.instanceBuffer, 0, VK_WHOLE_SIZE },
+            { frame.commandBuffer, 0, VK_WHOLE_SIZE },
+            { frame.countBuffer, 0, VK_WHOLE_SIZE }
+        };
+
+        std::array<VkWriteDescriptorSet, 4> writes = {};
+        for (uint32_t i = 0; i < writes.size(); i++)
+        {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].descriptorCount = 1;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+}
+
+void GpuCulling::createPipeline(VkPipelineCache pipelineCache, const std::vector<char>& shaderCode)
+{
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullParams);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling pipeline layout");
+    }
+
+    pipeline = buildPipeline(pipelineCache, shaderCode);
+}
+
+VkPipeline GpuCulling::buildPipeline(VkPipelineCache pipelineCache, const std::vector<char>& shaderCode) const
+{
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = shaderCode.size();
+    moduleInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling shader module");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+
+    VkPipeline newPipeline = VK_NULL_HANDLE;
+    VkResult result = vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &newPipeline);
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling pipeline");
+    }
+    return newPipeline;
+}
+
+VkPipeline GpuCulling::replacePipeline(VkPipeline newPipeline)
+{
+    VkPipeline oldPipeline = pipeline;
+    pipeline = newPipeline;
+    return oldPipeline;
+}
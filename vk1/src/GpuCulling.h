@@ -0,0 +1,104 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+
+#include <cstdint>
+#include <vector>
+
+//GPU驱动的绘制：计算着色器对每个物体的包围球做视锥剔除，为可见物体写入实例数据和VkDrawIndexedIndirectCommand，
+//渲染时用间接绘制读取这些指令，CPU上不再有逐物体的工作。
+//设备支持drawIndirectCount时可见物体的指令被压缩到缓冲开头，并由GPU写入的绘制数量决定绘制多少条；
+//否则每个物体固定占一条指令，不可见的物体instanceCount为0。
+//输出缓冲按并行帧各一份，这一帧剔除写入时上一帧的绘制可能还在读取另一份。
+class GpuCulling
+{
+public:
+    //物体的静态数据，布局和cull.comp中的ObjectData一致
+    struct ObjectData
+    {
+        glm::vec4 positionScale; //xyz为位置，w为缩放
+        glm::vec4 color;
+    };
+
+    //每帧的剔除参数，通过推送常量传给计算着色器，布局和cull.comp中的CullParams一致
+    struct CullParams
+    {
+        glm::vec4 frustumPlanes[6]; //xyz为指向视锥内部的单位法线，w为距离
+        float angle;                //所有物体绕z轴旋转的角度
+        float meshRadius;           //网格在模型空间的包围球半径
+        uint32_t objectCount;
+        uint32_t indexCount;
+        uint32_t compact;
+    };
+
+    //需要multiDrawIndirect和drawIndirectFirstInstance特性
+    static bool isSupported(VkPhysicalDevice physicalDevice);
+    //是否支持VK_KHR_draw_indirect_count扩展
+    static bool hasDrawIndirectCount(VkPhysicalDevice physicalDevice);
+    //从观察投影矩阵中提取六个视锥平面
+    static void extractFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]);
+
+    //shaderCode是cull.comp编译得到的SPIR-V，useDrawIndirectCount为true时设备必须已经启用对应扩展
+    void init(VkDevice device, MemoryAllocator& allocator, VkPipelineCache pipelineCache,
+        const std::vector<char>& shaderCode, uint32_t objectCount, uint32_t framesInFlight, bool useDrawIndirectCount);
+    void destroy();
+
+    //上传物体的静态数据，在上传管理器flush后由图形队列等待
+    void uploadObjects(UploadManager& uploadManager, const std::vector<ObjectData>& objects);
+
+    //在渲染流程外录制：清零绘制数量、执行剔除。结果被间接绘制、顶点输入和顶点着色器读取，
+    //这些读取之前的屏障由调用者录制(写入的阶段是TRANSFER和COMPUTE_SHADER)
+    void recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex, CullParams params);
+
+    //剔除输出被读取的阶段和访问方式
+    static const VkPipelineStageFlags OUTPUT_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+        | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+    static const VkAccessFlags OUTPUT_ACCESS = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+        | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    //在渲染流程内录制间接绘制，调用前需要绑定好图形管线、网格和描述符集
+    void recordDraw(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+    //剔除写入的实例数据，作为逐实例的顶点流绑定
+    VkBuffer getInstanceBuffer(uint32_t frameIndex) const { return frames[frameIndex].instanceBuffer; }
+    bool usesDrawIndirectCount() const { return drawIndexedIndirectCount != nullptr; }
+
+    //用新的着色器创建计算管线，沿用现有的管线布局，可以在其他线程上调用
+    VkPipeline buildPipeline(VkPipelineCache pipelineCache, const std::vector<char>& shaderCode) const;
+    //换上新管线，返回旧管线，调用者在使用它的帧完成之后销毁
+    VkPipeline replacePipeline(VkPipeline newPipeline);
+
+private:
+    struct FrameBuffers
+    {
+        VkBuffer instanceBuffer = VK_NULL_HANDLE;
+        Allocation instanceAllocation;
+        VkBuffer commandBuffer = VK_NULL_HANDLE;
+        Allocation commandAllocation;
+        VkBuffer countBuffer = VK_NULL_HANDLE;
+        Allocation countAllocation;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    uint32_t objectCount = 0;
+
+    VkBuffer objectBuffer = VK_NULL_HANDLE;
+    Allocation objectAllocation;
+    std::vector<FrameBuffers> frames;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, Allocation& allocation);
+    void destroyBuffer(VkBuffer& buffer, Allocation& allocation);
+    void createDescriptors(uint32_t framesInFlight);
+    void createPipeline(VkPipelineCache pipelineCache, const std::vector<char>& shaderCode);
+};
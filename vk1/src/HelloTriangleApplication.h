@@ -0,0 +1,3906 @@
+#pragma once
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "MemoryAllocator.h"
+#include "UniformRingBuffer.h"
+#include "ThreadPool.h"
+#include "PipelineCache.h"
+#include "UploadManager.h"
+#include "FrameProfiler.h"
+#include "FrameLimiter.h"
+#include "PresentLatency.h"
+#include "GpuCulling.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "VertexLayout.h"
+#include "ShaderWatcher.h"
+#include "BindlessDescriptors.h"
+#include "DeviceSelector.h"
+#include "TextureStreamer.h"
+#include "TimelineSemaphore.h"
+#include "RenderGraph.h"
+#include "RenderQueue.h"
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <optional>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#define LOG_ERROR(x) throw std::runtime_error(x)
+using namespace std::literals::chrono_literals;
+const uint32_t WIDTH = 800;
+const uint32_t HEIGHT = 600;
+const uint32_t MAX_FRAMES_IN_FLIGHT = 8; //并行帧数的上限，默认2帧，由--frames-in-flight指定
+const VkDeviceSize UNIFORM_RING_FRAME_SIZE = 256 * 1024; //每个并行帧在uniform环形缓冲中占用的大小
+const char* const CULL_SHADER_PATH = "./shader/cull_c.spv";
+//无绑定描述符集在管线布局中的位置，set 0是整帧共用的动态uniform缓冲
+const uint32_t BINDLESS_SET = 1;
+//渲染队列排序键中的pass和管线字段，深度预通道排在场景pass之前
+enum QueuePass : uint32_t
+{
+    QueuePassDepthPrepass = 0,
+    QueuePassScene = 1,
+};
+enum QueuePipeline : uint32_t
+{
+    QueuePipelineDepth = 0,
+    QueuePipelineColor = 1,
+};
+
+//运行参数，由命令行解析得到
+struct AppConfig
+{
+    //离屏模式：不创建窗口、表面和交换链，渲染到自己创建的VkImage上，用于无显示器的机器上测试和统计帧时间
+    bool headless = false;
+    //离屏模式下渲染的帧数
+    uint32_t frameCount = 1000;
+    //可以同时并行处理的帧数：越多CPU和GPU越不容易互相等待，但输入到画面的延迟也越长
+    uint32_t framesInFlight = 2;
+    //呈现模式，没有指定时依次选择MAILBOX、IMMEDIATE、FIFO
+    std::optional<VkPresentModeKHR> presentMode;
+    //交换链的图像数量，0表示最小数量加1，会被限制在表面允许的范围内
+    uint32_t swapchainImages = 0;
+    //主循环的帧率上限，0表示不限制
+    double fpsLimit = 0.0;
+    //指定使用的物理设备：枚举下标、设备UUID或者设备名称的一部分，为空时选择分数最高的可用设备
+    std::string device;
+    //每个物体的三角形数量，物体是细分成网格的四边形，默认2个三角形就是原来的四边形
+    uint32_t trianglesPerObject = 2;
+    //是否把渲染结果回读到主机内存
+    bool readback = false;
+    //回读的最后一帧写入的文件(ppm格式)，为空则不写
+    std::string readbackFile;
+    uint32_t width = WIDTH;
+    uint32_t height = HEIGHT;
+    //场景中绘制的物体数量
+    uint32_t objectCount = 1;
+    //实例化绘制：物体的变换和颜色放在逐实例的顶点流中，每个录制任务只需要一次绘制调用；
+    //关闭时每个物体一次绘制调用，用动态uniform偏移区分
+    bool instanced = true;
+    //GPU驱动的绘制：计算着色器做视锥剔除并生成间接绘制指令，需要实例化绘制
+    bool gpuCulling = false;
+    //无绑定资源：实例数据放在存储缓冲中，顶点着色器按句柄和gl_InstanceIndex读取，
+    //每个次级指令缓冲只绑定一次描述符集，不再有逐物体的描述符绑定
+    bool bindless = false;
+    //不使用实例化时，物体的变换和颜色通过推送常量随绘制调用传入，不写uniform也不重新绑定描述符集；
+    //关闭或者设备的maxPushConstantsSize放不下时使用动态uniform偏移
+    bool pushConstants = true;
+    //深度预通道：先用只读取位置流的管线写入深度，颜色pass只着色深度和它相等的片元，每个像素只着色一次
+    bool depthPrepass = false;
+    //不透明物体按到相机的距离从近到远绘制，被遮挡的片元在早期深度测试中被拒绝。GPU剔除时绘制顺序由计算着色器决定
+    bool frontToBack = true;
+    //录制指令的线程数，0表示使用全部硬件线程
+    uint32_t threadCount = 0;
+    //管线缓存文件，为空则不使用磁盘缓存
+    std::string pipelineCacheFile = "pipeline_cache.bin";
+    //退出时把每帧的计时导出到这些文件，为空则不导出
+    std::string timingCsvFile;
+    std::string timingJsonFile;
+    //从二进制网格文件加载物体的网格，为空则按trianglesPerObject生成
+    std::string meshFile;
+    //把生成的网格写入这个文件，为空则不写
+    std::string saveMeshFile;
+    //上传前重排生成的网格，提高顶点缓存命中率和顶点读取的局部性。网格文件在写入前已经优化过，加载时不再处理
+    bool optimizeMesh = true;
+    //生成的网格使用量化的顶点格式：SNORM16位置和UNORM8颜色，每个顶点8字节而不是20字节
+    bool quantizeVertices = false;
+    //监视着色器源文件和SPIR-V，变化时在后台线程上重建管线
+    bool watchShaders = false;
+    //热重载时编译着色器源文件的glslc，为空时使用VULKAN_SDK下的glslc
+    std::string shaderCompiler;
+    //所有物体使用的纹理文件，通过无绑定的图像数组采样，需要无绑定模式
+    std::string textureFile;
+    //把生成的纹理写入这个文件，没有指定textureFile时接着加载它
+    std::string saveTextureFile;
+    //纹理可以占用的显存(MB)，超出时只保留较粗的mip级别
+    uint32_t textureBudgetMB = 64;
+
+    static AppConfig parse(int argc, char** argv)
+    {
+        AppConfig config;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            //取参数后面紧跟的值
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc)
+                {
+                    throw std::runtime_error("missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--headless") config.headless = true;
+            else if (arg == "--frames") config.frameCount = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--device") config.device = value();
+            else if (arg == "--frames-in-flight") config.framesInFlight = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--present-mode") config.presentMode = parsePresentMode(value());
+            else if (arg == "--swapchain-images") config.swapchainImages = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--fps-limit") config.fpsLimit = std::stod(value());
+            else if (arg == "--readback") config.readback = true;
+            else if (arg == "--readback-file") { config.readback = true; config.readbackFile = value(); }
+            else if (arg == "--width") config.width = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--height") config.height = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--objects") config.objectCount = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--triangles") config.trianglesPerObject = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--no-instancing") config.instanced = false;
+            else if (arg == "--gpu-culling") config.gpuCulling = true;
+            else if (arg == "--bindless") config.bindless = true;
+            else if (arg == "--no-push-constants") config.pushConstants = false;
+            else if (arg == "--depth-prepass") config.depthPrepass = true;
+            else if (arg == "--no-front-to-back") config.frontToBack = false;
+            else if (arg == "--threads") config.threadCount = static_cast<uint32_t>(std::stoul(value()));
+            else if (arg == "--pipeline-cache") config.pipelineCacheFile = value();
+            else if (arg == "--no-pipeline-cache") config.pipelineCacheFile.clear();
+            else if (arg == "--timing-csv") config.timingCsvFile = value();
+            else if (arg == "--timing-json") config.timingJsonFile = value();
+            else if (arg == "--mesh") config.meshFile = value();
+            else if (arg == "--save-mesh") config.saveMeshFile = value();
+            else if (arg == "--no-mesh-optimization") config.optimizeMesh = false;
+            else if (arg == "--quantize-vertices") config.quantizeVertices = true;
+            else if (arg == "--watch-shaders") config.watchShaders = true;
+            else if (arg == "--shader-compiler") config.shaderCompiler = value();
+            else if (arg == "--texture") config.textureFile = value();
+            else if (arg == "--save-texture") config.saveTextureFile = value();
+            else if (arg == "--texture-budget") config.textureBudgetMB = static_cast<uint32_t>(std::stoul(value()));
+            else throw std::runtime_error("unknown argument: " + arg);
+        }
+        if (config.framesInFlight < 1 || config.framesInFlight > MAX_FRAMES_IN_FLIGHT)
+        {
+            throw std::runtime_error("--frames-in-flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+        }
+        //纹理句柄放在无绑定的图像数组中
+        if (!config.textureFile.empty() || !config.saveTextureFile.empty())
+        {
+            config.bindless = true;
+        }
+        //GPU剔除输出的是逐实例数据，只能用实例化的着色器绘制
+        if (config.gpuCulling)
+        {
+            config.instanced = true;
+        }
+        return config;
+    }
+
+    static VkPresentModeKHR parsePresentMode(const std::string& name)
+    {
+        if (name == "fifo") return VK_PRESENT_MODE_FIFO_KHR;
+        if (name == "fifo-relaxed") return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        if (name == "mailbox") return VK_PRESENT_MODE_MAILBOX_KHR;
+        if (name == "immediate") return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        throw std::runtime_error("unknown present mode: " + name + " (fifo, fifo-relaxed, mailbox, immediate)");
+    }
+};
+
+static const char* presentModeName(VkPresentModeKHR mode)
+{
+    switch (mode)
+    {
+    case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+    case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+    case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+    default: return "other";
+    }
+}
+
+//校验层列表
+const std::vector<const char*> validationLayers = {
+    "VK_LAYER_KHRONOS_validation"
+};
+//交换链扩展
+const std::vector<const char*> deviceExtensions = {
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+};
+
+//确认是否开启校验层
+#ifdef NDEBUG
+const bool enableValidationLayers = false;
+#else
+const bool enableValidationLayers = true;
+#endif
+
+static VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger) {
+    auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+    if (func != nullptr) {
+        return func(instance, pCreateInfo, pAllocator, pDebugMessenger);
+    }
+    else {
+        return VK_ERROR_EXTENSION_NOT_PRESENT;
+    }
+}
+
+static void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT debugMessenger, const VkAllocationCallbacks* pAllocator) {
+    auto func = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+    if (func != nullptr) {
+        func(instance, debugMessenger, pAllocator);
+    }
+}
+
+
+
+static std::vector<char> readFile(const std::string& filename)
+{
+    //ate：从文件尾部开始读取，binary：以二进制格式读取文件，避免出现行末格式转换（\n）
+    std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open file");
+    }
+    else
+    {
+        #ifndef NDEBUG
+        std::cout << "successfully read file" << "\n";
+        #endif // !NDEBUG   
+    }
+
+    //使用ate模式，可根据读取位置确定文件大小，分配足够数组空间容纳数据
+    size_t fileSize = (size_t)file.tellg();
+    std::vector<char> buffer(fileSize);
+
+    //跳到头部，读取文件
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+
+    //关闭
+    file.close();
+    return buffer;
+}
+
+struct QueueFamilyIndices
+{
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+    //上传数据使用的队列族，有专用的传输队列族时使用它，否则和图形队列族相同
+    std::optional<uint32_t> transferFamily;
+    //异步计算使用的队列族，有不支持图形的计算队列族时使用它，否则和图形队列族相同
+    std::optional<uint32_t> computeFamily;
+
+    bool isComplete()
+    {
+        return graphicsFamily.has_value() && presentFamily.has_value();
+    }
+};
+
+struct SwapChainSupportDetails
+{
+    //基础表面特征，如交换链的最大最小图像数量，宽高度
+    VkSurfaceCapabilitiesKHR capabilities;
+    //表面格式
+    std::vector<VkSurfaceFormatKHR> formats;
+    //可用的呈现模式
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+struct Vertex
+{
+    glm::vec2 pos;
+    glm::vec3 color;
+
+    //将CPU缓冲中的顶点数据的存放方式传递给GPU，使GPU可以正确的加载数据到显存中，
+    //绑定和属性描述由VertexLayout<Vertex>根据成员类型生成
+    static constexpr auto attributes() {
+        return makeVertexAttributes(VERTEX_ATTRIBUTE(Vertex, pos, 0), VERTEX_ATTRIBUTE(Vertex, color, 1));
+    }
+};
+
+//量化的顶点，和Vertex使用相同的location，着色器不需要区分。
+//位置除以网格的positionScale后打包成SNORM16，着色器中通过特化常量乘回来；颜色的第四个分量不使用
+struct PackedVertex
+{
+    Snorm16x2 pos;
+    Unorm8x4 color;
+
+    static constexpr auto attributes() {
+        return makeVertexAttributes(VERTEX_ATTRIBUTE(PackedVertex, pos, 0), VERTEX_ATTRIBUTE(PackedVertex, color, 1));
+    }
+
+    static PackedVertex pack(const Vertex& vertex, float positionScale)
+    {
+        return { packSnorm16x2(vertex.pos / positionScale), packUnorm8x4(glm::vec4(vertex.color, 1.0f)) };
+    }
+};
+
+//深度预通道的顶点只有位置，和Vertex/PackedVertex的pos相同，从交错的顶点中复制出来单独存放
+struct PositionVertex
+{
+    glm::vec2 pos;
+
+    static constexpr auto attributes() {
+        return makeVertexAttributes(VERTEX_ATTRIBUTE(PositionVertex, pos, 0));
+    }
+};
+
+struct PackedPositionVertex
+{
+    Snorm16x2 pos;
+
+    static constexpr auto attributes() {
+        return makeVertexAttributes(VERTEX_ATTRIBUTE(PackedPositionVertex, pos, 0));
+    }
+};
+
+static_assert(offsetof(Vertex, pos) == 0 && sizeof(Vertex::pos) == sizeof(PositionVertex),
+    "position stream is copied from the start of each vertex");
+static_assert(offsetof(PackedVertex, pos) == 0 && sizeof(PackedVertex::pos) == sizeof(PackedPositionVertex),
+    "position stream is copied from the start of each vertex");
+
+//逐实例的数据，实例化绘制时每个物体一份，通过VK_VERTEX_INPUT_RATE_INSTANCE的顶点流传给着色器
+struct InstanceData
+{
+    glm::mat4 model; //占用连续4个location，每列一个vec4
+    glm::vec4 color; //和顶点颜色相乘
+
+    static constexpr auto attributes() {
+        return makeVertexAttributes(VERTEX_ATTRIBUTE(InstanceData, model, 2), VERTEX_ATTRIBUTE(InstanceData, color, 6));
+    }
+};
+
+//一次实例化绘制：用同一个网格绘制实例缓冲中从firstInstance开始的instanceCount个实例
+struct InstanceBatch
+{
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+//四边形四个角的颜色，网格内部的顶点按位置双线性插值
+const glm::vec3 quadCornerColors[4] = {
+    {1.0f, 0.0f, 0.0f},
+    {0.0f, 1.0f, 0.0f},
+    {0.0f, 0.0f, 1.0f},
+    {1.0f, 1.0f, 1.0f}
+};
+
+//录制线程独占的指令池，指令池不能被多个线程同时使用，所以每个线程每个并行帧各一个
+struct WorkerCommandPool
+{
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    //从这个指令池分配的次级指令缓冲，重置指令池后仍然保留，下一帧直接复用
+    std::vector<VkCommandBuffer> secondaryBuffers;
+    uint32_t usedCount = 0;
+};
+
+//每个并行帧独占的资源，按并行帧数而不是交换链图像数量创建
+struct FrameResources
+{
+    //每帧开始时整个重置的指令池，以及从中分配的主指令缓冲
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    //每个录制线程的指令池
+    std::vector<WorkerCommandPool> workerPools;
+    //使用信号量来同步drawFrame函数中的操作
+    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+    VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
+    //这一帧上次提交触发的图形队列时间线值，等到这个值之后这一帧的资源才能复用
+    uint64_t timelineValue = 0;
+};
+
+//场景中的一个物体
+struct SceneObject
+{
+    glm::vec3 position;
+    float scale;
+    glm::vec4 color = glm::vec4(1.0f); //只在实例化绘制和推送常量绘制时使用
+    //材质编号，排序键中同一材质的绘制排在一起。目前所有物体共用一个网格和管线，都是0
+    uint32_t material = 0;
+};
+
+//描述符布局，这里只使用uniform缓冲对象
+struct UniformBufferObject
+{
+    glm::mat4 model;
+    glm::mat4 view;
+    glm::mat4 proj;
+};
+
+//无绑定模式下整帧共用的uniform数据，物体的变换在instanceBuffer句柄指向的存储缓冲中
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 proj;
+    uint32_t instanceBuffer;
+    uint32_t texture; //无绑定图像数组中的句柄，没有纹理时为BindlessDescriptors::INVALID_HANDLE
+};
+
+//逐物体绘制时的推送常量，和实例数据的内容相同，布局和shader_push.vert中的DrawConstants一致
+using DrawPushConstants = InstanceData;
+
+//一次运行的统计结果，基准测试程序在run()返回后读取
+struct RunStats
+{
+    std::string deviceName;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t objectCount = 0;
+    uint32_t trianglesPerObject = 0;
+    uint32_t frames = 0;
+    //主循环的总时间和平均帧率
+    double loopMs = 0.0;
+    double fps = 0.0;
+    double startupMs = 0.0;
+    //启动时上传网格数据：CPU上写入暂存缓冲并提交花费的时间，以及从开始上传到确认传输完成的时间
+    double uploadSubmitMs = 0.0;
+    double uploadCompleteMs = 0.0;
+    VkDeviceSize uploadBytes = 0;
+    //从网格文件加载时，映射文件并把数据写入暂存缓冲的时间，生成网格时为0
+    double meshLoadMs = 0.0;
+    //录制次级指令缓冲时实际录制的管线、描述符集和顶点缓冲绑定，以及和当前状态相同而跳过的绑定，是整个运行的总数
+    uint64_t recordedBinds = 0;
+    uint64_t skippedBinds = 0;
+    //流式纹理：主循环结束时驻留的显存和累计上传的字节数
+    VkDeviceSize textureResidentBytes = 0;
+    VkDeviceSize textureStreamedBytes = 0;
+    //各阶段和GPU的帧时间统计
+    FrameProfiler::Summary timing;
+    //主循环结束时的内存占用
+    MemoryStats memory;
+    MemoryStats deviceLocalMemory;
+};
+
+class HelloTriangleApplication {
+public:
+    HelloTriangleApplication(const AppConfig& config = AppConfig()) : config(config) {}
+
+    void run() {
+        //中途抛出异常时也释放已经创建的对象，基准测试之后的运行不会带着泄漏的设备和内存
+        try
+        {
+            //离屏模式不需要窗口
+            if (!config.headless)
+            {
+                initWindow();
+            }
+            initVulkan();
+            mainLoop();
+        }
+        catch (...)
+        {
+            cleanup();
+            throw;
+        }
+        cleanup();
+    }
+
+    const RunStats& getRunStats() const { return runStats; }
+
+    //最近一次回读到主机内存的像素(RGBA8)
+    const std::vector<uint8_t>& getReadbackPixels() const { return readbackPixels; }
+
+    //修改相机，观察矩阵在下一帧重新计算
+    void setCamera(const glm::vec3& eye, const glm::vec3& target, const glm::vec3& up)
+    {
+        cameraEye = eye;
+        cameraTarget = target;
+        cameraUp = up;
+        cameraDirty = true;
+    }
+
+private:
+    AppConfig config;
+
+    GLFWwindow* window = nullptr;
+
+    //vk实例，最关键的部分，填其createinfo
+    VkInstance instance;
+
+    //校验层对象，用于存放注册调试回调函数
+    VkDebugUtilsMessengerEXT debugMessenger;
+
+    //物理设备,随vkinstance清除而自动清除
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+
+    //逻辑设备，和物理设备交互的接口，同一个物理设备可支持多个逻辑设备
+    VkDevice device;
+
+    //设备内存分配器
+    MemoryAllocator allocator;
+
+    //创建逻辑设备时指定的队列会随着逻辑设备一同被创建,自动清除
+    VkQueue graphicsQueue;
+    VkQueue presentQueue;
+    VkQueue transferQueue;
+    //计算队列族和图形队列族不同时是独立的队列，可以和图形工作并行执行
+    VkQueue computeQueue;
+    //每个队列一条时间线信号量，计算或传输和图形使用同一个队列时共用图形队列的时间线
+    TimelineSemaphore graphicsTimeline;
+    TimelineSemaphore computeTimeline;
+    TimelineSemaphore transferTimeline;
+
+    //抽象出可供Vulkan渲染的窗口表面
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+    //存储交换链
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+    std::vector<VkImage> swapChainImages;
+    std::vector<VkImageView> swapChainImageViews;
+    VkFormat swapChainImageFormat; //交换链图像格式
+    VkExtent2D swapChainExtent;    //交换链范围（宽高）
+    VkPresentModeKHR swapChainPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+    //渲染
+    //一帧的渲染图，渲染流程和帧缓冲都由它创建，交换链变化时重新声明
+    RenderGraph renderGraph;
+    RenderGraph::PassHandle scenePass = 0;
+    //场景pass的渲染流程，图形管线按它创建
+    VkRenderPass renderPass;
+    //深度缓冲的格式，按设备支持选择
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    //深度预通道和它的渲染流程，深度管线按它创建
+    RenderGraph::PassHandle depthPrepassPass = 0;
+    VkRenderPass depthRenderPass = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout; //存储描述符绑定信息
+    VkPipelineLayout pipelineLayout;
+    VkPipeline graphicsPipeline;
+    //深度预通道的管线，只有顶点着色器
+    VkPipeline depthPipeline = VK_NULL_HANDLE;
+    //管线缓存，启动时从磁盘读取，退出时写回
+    PipelineCache pipelineCache;
+    //最近一次创建图形管线花费的时间(毫秒)
+    double pipelineCreateTime = 0.0;
+    //批量上传顶点、索引等数据，在传输队列上异步执行
+    UploadManager uploadManager;
+    //这一帧的图形提交需要额外等待的上传时间线和它的值
+    std::vector<VkSemaphore> uploadWaitSemaphores;
+    std::vector<uint64_t> uploadWaitValues;
+    std::vector<VkPipelineStageFlags> uploadWaitStages;
+    //每个并行帧的指令池、指令缓冲和同步对象
+    std::vector<FrameResources> frames;
+    size_t currentFrame = 0;
+    //录制次级指令缓冲的线程池
+    std::unique_ptr<ThreadPool> threadPool;
+    //每个录制任务产生的次级指令缓冲，按任务顺序在主指令缓冲中执行
+    std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
+    //帧计时，CPU各阶段和GPU时间戳
+    FrameProfiler profiler;
+    //帧率限制和从提交到呈现的延迟
+    FrameLimiter frameLimiter;
+    PresentLatency presentLatency;
+    bool presentWaitEnabled = false;
+    RunStats runStats;
+    //启动时上传网格数据的批次，确认完成后记录上传耗时
+    uint64_t initialUploadBatch = 0;
+    bool initialUploadTimed = false;
+    std::chrono::high_resolution_clock::time_point uploadStartTime;
+
+    //场景物体，每个物体在uniform环形缓冲中占用一段，使用各自的动态偏移绘制
+    std::vector<SceneObject> sceneObjects;
+    //每帧的渲染队列，排序之后深度预通道和场景pass各自按自己的区间绘制，
+    //区间中第k个绘制包是这个pass第k个绘制的物体
+    RenderQueue renderQueue;
+    const RenderQueue::DrawPacket* prepassPackets = nullptr;
+    const RenderQueue::DrawPacket* scenePackets = nullptr;
+    //所有录制线程实际录制和跳过的绑定次数
+    std::atomic<uint64_t> recordedBinds{ 0 };
+    std::atomic<uint64_t> skippedBinds{ 0 };
+    float animationTime = 0.0f;
+    //窗口大小变化的回调只设置标记，在下一帧开始时统一处理
+    bool framebufferResized = false;
+    bool swapChainSuboptimal = false;
+
+    //所有物体共用的网格，程序生成时数据在vertices/indices中(量化时在packedVertices中)，从文件加载时直接指向meshFile的映射
+    std::vector<Vertex> vertices;
+    std::vector<PackedVertex> packedVertices;
+    std::vector<uint32_t> indices;
+    bool meshQuantized = false;
+    //量化位置的还原系数，作为特化常量传给顶点着色器
+    float meshPositionScale = 1.0f;
+    MeshFile meshFile;
+    const void* meshVertexData = nullptr;
+    const void* meshIndexData = nullptr;
+    VkDeviceSize meshVertexBytes = 0;
+    VkDeviceSize meshIndexBytes = 0;
+    uint32_t meshVertexCount = 0;
+    uint32_t meshIndexCount = 0;
+    VkIndexType meshIndexType = VK_INDEX_TYPE_UINT32;
+    //顶点缓冲，开启深度预通道时交错的顶点之后是只有位置的顶点流
+    VkBuffer vertexBuffer;
+    VkDeviceSize meshPositionOffset = 0;
+    Allocation vertexBufferAllocation;
+    //索引缓冲
+    VkBuffer indexBuffer;
+    Allocation indexBufferAllocation;
+    //uniform缓冲，所有并行帧共用一个保持映射的环形缓冲，通过动态偏移区分
+    UniformRingBuffer uniformRing;
+    //逐实例数据的环形缓冲，和uniform缓冲一样按并行帧切分，作为顶点缓冲绑定
+    UniformRingBuffer instanceRing;
+    //这一帧的实例数据在instanceRing中的偏移
+    uint32_t instanceBase = 0;
+    //GPU剔除，开启后实例数据和绘制指令都由计算着色器生成
+    GpuCulling gpuCulling;
+    bool drawIndirectCountEnabled = false;
+    GpuCulling::CullParams cullParams = {};
+    //这一帧uniform数据在环形缓冲中的起点，录制场景pass时使用
+    uint32_t frameUniformBase = 0;
+    //网格在模型空间的包围球半径
+    float meshRadius = 0.0f;
+    //无绑定描述符，每个并行帧的实例数据各占一个存储缓冲句柄
+    BindlessDescriptors bindless;
+    std::vector<uint32_t> instanceBufferHandles;
+    //按显存预算流式加载的纹理
+    TextureStreamer textureStreamer;
+    uint32_t sceneTexture = UINT32_MAX;
+    //着色器热重载，后台线程创建好的管线放在pending中，下一帧开始时替换
+    ShaderWatcher shaderWatcher;
+    //后台线程创建图形管线时持有，交换链重建替换渲染流程时也要持有
+    std::mutex pipelineBuildMutex;
+    std::mutex reloadMutex;
+    VkPipeline pendingGraphicsPipeline = VK_NULL_HANDLE;
+    VkPipeline pendingDepthPipeline = VK_NULL_HANDLE;
+    VkPipeline pendingCullPipeline = VK_NULL_HANDLE;
+    //被替换下来的管线可能还在被之前提交的帧使用，图形队列的时间线到达替换时最后提交的值之后再销毁
+    struct RetiredPipeline
+    {
+        VkPipeline pipeline;
+        uint64_t timelineValue;
+    };
+    std::vector<RetiredPipeline> retiredPipelines;
+    //描述符池
+    VkDescriptorPool descriptorPool;
+    //描述符集，使用动态uniform缓冲后只需要一个
+    VkDescriptorSet descriptorSet;
+
+    //相机，观察矩阵和投影矩阵只在相机或者交换链范围变化时重新计算
+    glm::vec3 cameraEye = glm::vec3(2.0f, 2.0f, 2.0f);
+    glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, 0.0f);
+    glm::vec3 cameraUp = glm::vec3(0.0f, 0.0f, 1.0f);
+    bool cameraDirty = true;
+    VkExtent2D projExtent = { 0, 0 };
+    glm::mat4 cachedView;
+    glm::mat4 cachedProj;
+
+    //离屏模式下代替交换链的渲染目标，图像句柄和视图仍放在swapChainImages/swapChainImageViews中
+    std::vector<Allocation> offscreenImagesAllocation;
+    //回读用的主机可见缓冲，每个离屏图像一个，分配器会让它一直保持映射
+    std::vector<VkBuffer> readbackBuffers;
+    std::vector<Allocation> readbackBuffersAllocation;
+    std::vector<bool> readbackPending;
+    std::vector<uint8_t> readbackPixels;
+
+    void initWindow() {
+        glfwInit();
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+
+        window = glfwCreateWindow(config.width, config.height, "Vulkan", nullptr, nullptr);
+
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+
+
+    }
+
+    static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
+    {
+        auto app = reinterpret_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+        app->framebufferResized = true;
+    }
+
+    void initVulkan() {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        //创建Vulkan实例
+        createInstance();
+        //启动校验层
+        setupDebugMessenger();
+        //添加窗口表面,让Vulkan渲染到这上面去，离屏模式下没有窗口表面
+        if (!config.headless)
+        {
+            createSurface();
+        }
+        //选择物理设备
+        pickPhysicalDevice();
+        //创建逻辑设备，对应物理设备
+        createLogicalDevice();
+        //每个队列的时间线信号量，之后的提交和等待都按它们的值进行
+        createTimelines();
+        //内存分配器，之后所有缓冲和图像的内存都从它管理的大块内存中切分
+        allocator.init(physicalDevice, device);
+        //管线缓存，和设备或驱动不匹配的缓存文件会被丢弃
+        pipelineCache.create(physicalDevice, device, config.pipelineCacheFile);
+        if (config.headless)
+        {
+            //离屏模式下自己创建渲染目标图像代替交换链
+            createOffscreenTargets();
+        }
+        else
+        {
+            //创建交换链
+            createSwapChain();
+            //为交换链中的每个图像创建视图
+            createImageViews();
+        }
+        //深度缓冲是渲染图中的临时图像，格式按设备支持选择
+        depthFormat = findDepthFormat();
+        //声明渲染图并编译，创建渲染流程、帧缓冲和屏障，需要在创建图形管线之前
+        renderGraph.init(device, allocator);
+        buildRenderGraph();
+        renderGraph.printSummary();
+        //创建描述符布局
+        createDescriptorSetLayout();
+        //无绑定描述符集的布局是管线布局的一部分，资源在创建之后逐个写入
+        if (config.bindless)
+        {
+            bindless.init(device, physicalDevice, 1024, 4096);
+        }
+        //场景物体和网格，管线的顶点输入格式取决于网格的顶点格式，所以在创建管线之前
+        createScene();
+        auto meshStartTime = std::chrono::high_resolution_clock::now();
+        createMesh();
+        double meshCreateMs = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - meshStartTime).count();
+        //创建图形管线
+        createGraphicsPipeline();
+        //上传管理器，在传输队列上批量执行数据拷贝
+        createUploadManager();
+        //创建顶点缓冲,索引缓冲,uniform缓冲
+        uploadStartTime = std::chrono::high_resolution_clock::now();
+        createVertexBuffer();
+        createIndexBuffer();
+        if (!config.meshFile.empty())
+        {
+            //数据已经拷贝到暂存缓冲，映射不再需要
+            runStats.meshLoadMs = meshCreateMs + std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - uploadStartTime).count();
+            double megabytes = static_cast<double>(meshVertexBytes + meshIndexBytes) / (1024.0 * 1024.0);
+            printf("mesh: %s, %.1f MB mapped and staged in %.3f ms (%.0f MB/s)\n", config.meshFile.c_str(),
+                megabytes, runStats.meshLoadMs, runStats.meshLoadMs > 0.0 ? megabytes * 1000.0 / runStats.meshLoadMs : 0.0);
+            meshFile.close();
+        }
+        //GPU剔除的缓冲和计算管线，物体数据和网格一起上传
+        if (config.gpuCulling)
+        {
+            createGpuCulling();
+        }
+        //顶点和索引数据的拷贝合并成一次提交，不等待完成，第一帧绘制前由图形队列等待
+        initialUploadBatch = uploadManager.flush();
+        runStats.uploadSubmitMs = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - uploadStartTime).count();
+        runStats.uploadBytes = meshVertexBytes + meshIndexBytes;
+        createUniformBuffer();
+        //创建描述符池
+        createDescriptorPool();
+        //创建描述符集
+        createDescriptorSets();
+        //纹理的尾部mip级别在后台上传，完成之前物体不采样纹理
+        createTextures();
+        //为每个并行帧创建指令池并分配指令缓冲，绘制指令在每帧绘制时录制
+        createFrameResources();
+        //帧计时，离屏模式或者需要导出时保存每一帧的记录
+        profiler.init(physicalDevice, device, findQueueFamilies(physicalDevice).graphicsFamily.value(), config.framesInFlight,
+            config.headless || !config.timingCsvFile.empty() || !config.timingJsonFile.empty());
+        presentLatency.init(device, presentWaitEnabled, profiler, graphicsTimeline);
+        frameLimiter.setTargetFps(config.fpsLimit);
+        //建立信号量来同步指令队列中的操作
+        createSyncObjects();
+        //着色器热重载
+        if (config.watchShaders)
+        {
+            createShaderWatcher();
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        runStats.startupMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+        printf("startup: %.3f ms (pipeline %.3f ms, pipeline cache %s)\n",
+            runStats.startupMs, pipelineCreateTime, pipelineCache.isWarm() ? "warm" : "cold");
+        printf("pacing: %s, %zu images, %u frames in flight, fps limit %s, latency measured to %s\n",
+            config.headless ? "offscreen" : presentModeName(swapChainPresentMode), swapChainImages.size(),
+            config.framesInFlight, config.fpsLimit > 0.0 ? std::to_string(config.fpsLimit).c_str() : "off",
+            presentLatency.usesPresentWait() ? "present" : "GPU completion");
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        runStats.deviceName = properties.deviceName;
+        runStats.width = swapChainExtent.width;
+        runStats.height = swapChainExtent.height;
+        runStats.objectCount = static_cast<uint32_t>(sceneObjects.size());
+        runStats.trianglesPerObject = meshIndexCount / 3;
+    }
+
+    void mainLoop() {
+        if (config.headless)
+        {
+            offscreenLoop();
+            return;
+        }
+
+        auto loopStart = std::chrono::high_resolution_clock::now();
+        uint32_t frame = 0;
+        while (!glfwWindowShouldClose(window)) {
+            //先等到这一帧的开始时间再处理输入，输入到画面的延迟最短
+            frameLimiter.wait();
+            glfwPollEvents();
+
+            drawFrame();
+            runStats.frames++;
+
+            //每1000帧打印一次最近这些帧的帧时间分布
+            if (++frame == 1000)
+            {
+                profiler.printRolling();
+                frame = 0;
+            }
+
+        }
+
+        vkDeviceWaitIdle(device); //drawFrame函数中的操作是异步进行的，这里进行一下同步，等device中所有操作执行完了再进入下一步
+        finishRunStats(loopStart);
+
+        exportTiming();
+    }
+
+    //主循环结束后补全运行统计
+    void finishRunStats(std::chrono::high_resolution_clock::time_point loopStart)
+    {
+        runStats.loopMs = std::chrono::duration<double, std::milli>(
+            std::chrono::high_resolution_clock::now() - loopStart).count();
+        runStats.fps = runStats.loopMs > 0.0 ? runStats.frames * 1000.0 / runStats.loopMs : 0.0;
+        runStats.timing = profiler.summarize();
+        runStats.recordedBinds = recordedBinds.load();
+        runStats.skippedBinds = skippedBinds.load();
+
+        //所有设备本地内存类型的占用之和
+        runStats.memory = allocator.getStats();
+        runStats.textureResidentBytes = textureStreamer.getStats().residentBytes;
+        runStats.textureStreamedBytes = textureStreamer.getStats().streamedBytes;
+        const VkPhysicalDeviceMemoryProperties& memProperties = allocator.getMemoryProperties();
+        runStats.deviceLocalMemory = MemoryStats();
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+        {
+            if (memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+            {
+                MemoryStats stats = allocator.getStats(i);
+                runStats.deviceLocalMemory.blockCount += stats.blockCount;
+                runStats.deviceLocalMemory.allocationCount += stats.allocationCount;
+                runStats.deviceLocalMemory.blockBytes += stats.blockBytes;
+                runStats.deviceLocalMemory.usedBytes += stats.usedBytes;
+            }
+        }
+    }
+
+    //回收已经完成的上传批次，启动时的上传第一次确认完成时记录耗时
+    void collectUploads()
+    {
+        uploadManager.collect();
+
+        if (!initialUploadTimed && uploadManager.isComplete(initialUploadBatch))
+        {
+            runStats.uploadCompleteMs = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - uploadStartTime).count();
+            initialUploadTimed = true;
+        }
+    }
+
+    //打印整个运行期间的帧时间统计，并按参数导出每帧的记录
+    void exportTiming()
+    {
+        profiler.printSummary();
+
+        if (!config.timingCsvFile.empty() && !profiler.writeCsv(config.timingCsvFile))
+        {
+            std::cerr << "failed to write " << config.timingCsvFile << std::endl;
+        }
+        if (!config.timingJsonFile.empty() && !profiler.writeJson(config.timingJsonFile))
+        {
+            std::cerr << "failed to write " << config.timingJsonFile << std::endl;
+        }
+    }
+
+    void cleanup() {
+
+        //先停止热重载线程，之后不会再有新管线被创建
+        shaderWatcher.stop();
+
+        //初始化中途失败时设备可能还没有创建；运行中途失败时队列中可能还有没执行完的指令
+        if (device != VK_NULL_HANDLE)
+        {
+            vkDeviceWaitIdle(device);
+
+            destroyReloadedPipelines();
+
+            cleanupSwapChain();
+
+            vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+
+            textureStreamer.destroy();
+            bindless.destroy();
+
+            uniformRing.destroy();
+            instanceRing.destroy();
+
+            destroyBuffer(vertexBuffer, vertexBufferAllocation);
+
+            destroyBuffer(indexBuffer, indexBufferAllocation);
+
+            uploadManager.destroy();
+
+            profiler.destroy();
+
+            gpuCulling.destroy();
+
+            cleanupFrameResources();
+
+            //管线缓存写回磁盘，下次启动时创建管线更快
+            pipelineCache.save();
+            pipelineCache.destroy();
+
+#ifndef NDEBUG
+            allocator.printStats();
+#endif
+            allocator.destroy();
+
+            destroyTimelines();
+
+            vkDestroyDevice(device, nullptr);
+        }
+
+        if (surface != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        }
+
+        if (enableValidationLayers && instance != VK_NULL_HANDLE) {
+            DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+        }
+
+        vkDestroyInstance(instance, nullptr);
+
+        if (window != nullptr)
+        {
+            glfwDestroyWindow(window);
+
+            glfwTerminate();
+        }
+    }
+
+#pragma region 实例创建
+    void createInstance() {
+        if (enableValidationLayers && !checkValidationLayerSupport()) {
+            throw std::runtime_error("validation layers requested, but not available!");
+        }
+
+        VkApplicationInfo appInfo{};
+        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.pApplicationName = "Hello Triangle";
+        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+        appInfo.pEngineName = "No Engine";
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+        //帧和上传的同步使用1.2的时间线信号量，无绑定模式的描述符索引特性和选择设备时的UUID查询也依赖这个版本
+        appInfo.apiVersion = VK_API_VERSION_1_2;
+
+        VkInstanceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+
+        auto extensions = getRequiredExtensions();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo{};
+        if (enableValidationLayers) {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+            createInfo.ppEnabledLayerNames = validationLayers.data();
+
+            populateDebugMessengerCreateInfo(debugCreateInfo);
+            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
+        }
+        else {
+            createInfo.enabledLayerCount = 0;
+
+            createInfo.pNext = nullptr;
+        }
+
+        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create instance!");
+        }
+    }
+#pragma endregion
+
+#pragma region 校验层
+
+    void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
+        createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+        createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        createInfo.pfnUserCallback = debugCallback;
+    }
+
+    void setupDebugMessenger() {
+        if (!enableValidationLayers) return;
+
+        VkDebugUtilsMessengerCreateInfoEXT createInfo;
+        populateDebugMessengerCreateInfo(createInfo);
+
+        if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
+            throw std::runtime_error("failed to set up debug messenger!");
+        }
+    }
+
+    //返回所需要的扩展列表
+    std::vector<const char*> getRequiredExtensions() {
+        std::vector<const char*> extensions;
+
+        //离屏模式不需要窗口系统相关的扩展
+        if (!config.headless)
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
+
+        if (enableValidationLayers) {
+            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        return extensions;
+    }
+
+    //请求所有可用校验层
+    bool checkValidationLayerSupport() {
+        uint32_t layerCount;
+        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+        std::vector<VkLayerProperties> availableLayers(layerCount);
+
+        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+        for (const char* layerName : validationLayers) {
+            bool layerFound = false;
+
+
+            for (const auto& layerProperties : availableLayers) {
+                if (strcmp(layerName, layerProperties.layerName) == 0) {
+                    layerFound = true;
+                    break;
+                }
+            }
+
+            if (!layerFound) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+        VkDebugUtilsMessageTypeFlagsEXT messageType,
+        const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
+        std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
+
+        return VK_FALSE;
+    }
+#pragma endregion
+
+#pragma region 物理设备与逻辑设备
+    //查询系统中的显卡设备，选择需要的特性的设备使用，vk支持选择任意数量的显卡设备
+    void pickPhysicalDevice()
+    {
+        //请求显卡列表和请求扩展列表的操作类似
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+
+        //如果可用的显卡数量为0，则无法运行
+        if (deviceCount == 0)
+        {
+            throw std::runtime_error("no GPU supporting vulkan");
+        }
+
+        //按设备类型、显存大小和限制排序，多显卡的机器上不再取决于驱动的枚举顺序
+        std::vector<DeviceSelector::Candidate> candidates = DeviceSelector::enumerate(instance, true);
+        DeviceSelector::rank(candidates);
+
+        for (const auto& candidate : candidates)
+        {
+            bool suitable = isDeviceSuitable(candidate.device);
+            bool selected = config.device.empty() || DeviceSelector::matches(candidate, config.device);
+            printf("device %u: %s (%s, %.0f MB device local, score %llx)%s%s\n", candidate.index,
+                candidate.properties.deviceName, DeviceSelector::typeName(candidate.properties.deviceType),
+                candidate.deviceLocalBytes / (1024.0 * 1024.0), static_cast<unsigned long long>(candidate.score),
+                candidate.hasUuid ? (" uuid " + DeviceSelector::formatUuid(candidate.uuid)).c_str() : "",
+                suitable ? "" : " [unsuitable]");
+
+            //检查设备，第一个满足要求的就是分数最高的
+            if (physicalDevice == VK_NULL_HANDLE && suitable && selected)
+            {
+                physicalDevice = candidate.device;
+            }
+        }
+
+        if (physicalDevice == VK_NULL_HANDLE)
+        {
+            if (!config.device.empty())
+            {
+                throw std::runtime_error("no suitable GPU matches --device " + config.device);
+            }
+            throw std::runtime_error("failed to find suitable GPU");
+        }
+    }
+
+    //检查设备是否满足要求
+    bool isDeviceSuitable(VkPhysicalDevice device)
+    {
+        //检查设备是否支持对应的队列族
+        QueueFamilyIndices indices = findQueueFamilies(device);
+
+        //检查设备是否支持我们需要的扩展
+        bool extensionsSupported = checkDeviceExtensionSupport(device);
+        
+        //检查交换链是否满足条件(在这里是：至少支持一种图像格式和一种支持我们的窗口表面的呈现模式)
+        //离屏模式没有交换链，不需要检查
+        bool swapChainAdequate = config.headless;
+        if (extensionsSupported && !config.headless)
+        {
+            SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
+            swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+        }
+
+        //所有队列之间以及CPU和GPU之间的同步都使用时间线信号量
+        bool timelineSupported = TimelineSemaphore::isSupported(device);
+
+        return indices.isComplete() && extensionsSupported && swapChainAdequate && timelineSupported;
+    }
+
+    //我们需要检测设备支持的队列族，以及其中哪些支持我们使用的指令，使用下面的函数实现这个需求
+    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device)
+    {
+        QueueFamilyIndices indices;
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+        //VkQueueFamilyProperties结构体包含了队列族的很多信息，比如支持的操作类型，该队列族可以创建的队列个数。
+        //这里需要找到支持的队列族。检查所有队列族，同时支持图形和呈现的队列族优先，这样不需要在两个队列之间转移交换链图像
+        for (uint32_t i = 0; i < queueFamilyCount; i++)
+        {
+            const VkQueueFamilyProperties& queueFamily = queueFamilies[i];
+            if (queueFamily.queueCount == 0)
+                continue;
+
+            //检查设备是否具有呈现渲染结果到窗口表面的能力，离屏模式不呈现，不需要检查
+            VkBool32 presentSurpport = false;
+            if (surface != VK_NULL_HANDLE)
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSurpport);
+
+            //检查设备是否有图形渲染能力
+            bool graphics = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+            if (graphics && (presentSurpport || config.headless))
+            {
+                indices.graphicsFamily = i;
+                indices.presentFamily = i;
+                break;
+            }
+            if (graphics && !indices.graphicsFamily.has_value())
+                indices.graphicsFamily = i;
+            if (presentSurpport && !indices.presentFamily.has_value())
+                indices.presentFamily = i;
+        }
+
+        #ifndef NDEBUG
+        if (indices.isComplete())
+        {
+            std::cout << "find out queueFamily successfully, graphics " << indices.graphicsFamily.value()
+                << ", present " << indices.presentFamily.value() << std::endl;
+        }
+        #endif // DEBUG
+
+        //专用的计算队列族：支持计算但不支持图形，提交到这里的计算可以和图形工作重叠执行。
+        //图形队列族总是隐含支持计算，找不到时直接用图形队列族
+        for (uint32_t j = 0; j < queueFamilyCount; j++)
+        {
+            VkQueueFlags flags = queueFamilies[j].queueFlags;
+            if (queueFamilies[j].queueCount > 0 && (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                indices.computeFamily = j;
+                break;
+            }
+        }
+        if (!indices.computeFamily.has_value())
+            indices.computeFamily = indices.graphicsFamily;
+
+        //寻找专用的传输队列族：支持传输但不支持图形，其中不支持计算的通常直接对应DMA引擎，优先使用。
+        //图形队列族总是隐含支持传输，找不到时直接用图形队列族
+        int bestScore = 0;
+        for (uint32_t j = 0; j < queueFamilyCount; j++)
+        {
+            VkQueueFlags flags = queueFamilies[j].queueFlags;
+            if (queueFamilies[j].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+                continue;
+
+            int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+            if (score > bestScore)
+            {
+                bestScore = score;
+                indices.transferFamily = j;
+            }
+        }
+        if (!indices.transferFamily.has_value())
+            indices.transferFamily = indices.graphicsFamily;
+
+        //找到了，返回对应的队列族索引，具体而言是图形队列族、呈现队列族、计算队列族以及传输队列族
+        return indices;
+    }
+
+    void createLogicalDevice()
+    {
+        //得到队列族的索引
+        QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        //图形和呈现共用图形队列族的第一个队列；计算和传输不在图形队列族时各自使用一个队列，
+        //两者落在同一个队列族并且它有多个队列时分开，避免上传和异步计算的提交互相加锁
+        std::map<uint32_t, uint32_t> queueCounts;
+        queueCounts[indices.graphicsFamily.value()] = 1;
+        queueCounts[indices.presentFamily.value()] = std::max(queueCounts[indices.presentFamily.value()], 1u);
+        auto takeQueue = [&](uint32_t family) -> uint32_t {
+            if (family == indices.graphicsFamily.value())
+                return 0;
+            uint32_t index = std::min(queueCounts[family], queueFamilies[family].queueCount - 1);
+            queueCounts[family] = std::max(queueCounts[family], index + 1);
+            return index;
+        };
+        uint32_t computeQueueIndex = takeQueue(indices.computeFamily.value());
+        uint32_t transferQueueIndex = takeQueue(indices.transferFamily.value());
+
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        std::vector<float> queuePriorities(std::max_element(queueCounts.begin(), queueCounts.end(),
+            [](const auto& a, const auto& b) { return a.second < b.second; })->second, 1.0f);
+        for (const auto& queueCount : queueCounts)
+        {
+            //创建逻辑设备，需填写createinfo
+            VkDeviceQueueCreateInfo queueCreateInfo = {};
+            queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex = queueCount.first;
+            queueCreateInfo.queueCount = queueCount.second;
+            queueCreateInfo.pQueuePriorities = queuePriorities.data();
+            queueCreateInfos.push_back(queueCreateInfo);
+        }
+        
+        //指定使用的设备特性
+        VkPhysicalDeviceFeatures deviceFeatures = {};
+        //GPU剔除需要一次间接绘制调用执行多条指令，并且指令中的firstInstance不为0
+        if (config.gpuCulling)
+        {
+            if (GpuCulling::isSupported(physicalDevice))
+            {
+                deviceFeatures.multiDrawIndirect = VK_TRUE;
+                deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+            }
+            else
+            {
+                printf("gpu culling: multiDrawIndirect or drawIndirectFirstInstance not supported, using CPU instancing\n");
+                config.gpuCulling = false;
+            }
+        }
+        if (config.bindless && !BindlessDescriptors::isSupported(physicalDevice))
+        {
+            printf("bindless: descriptor indexing not supported, using per-draw descriptor binding\n");
+            config.bindless = false;
+        }
+        //规范只保证128字节的推送常量
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+        if (config.pushConstants && sizeof(DrawPushConstants) > deviceProperties.limits.maxPushConstantsSize)
+        {
+            printf("push constants: %zu bytes per draw exceed maxPushConstantsSize (%u), using dynamic uniform offsets\n",
+                sizeof(DrawPushConstants), deviceProperties.limits.maxPushConstantsSize);
+            config.pushConstants = false;
+        }
+
+        //创建逻辑设备
+        VkDeviceCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        
+        createInfo.queueCreateInfoCount = queueCreateInfos.size();
+        createInfo.pQueueCreateInfos = queueCreateInfos.data();
+
+        //呈现等待用来测量从提交到呈现的延迟，不支持时退回到用图形队列的时间线测量
+        presentWaitEnabled = !config.headless && PresentLatency::isSupported(physicalDevice);
+
+        //时间线信号量、描述符索引和呈现等待的特性只能通过VkPhysicalDeviceFeatures2链启用，这时pEnabledFeatures必须为空
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = TimelineSemaphore::requiredFeatures();
+        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = BindlessDescriptors::requiredFeatures();
+        PresentLatency::Features presentFeatures = PresentLatency::requiredFeatures();
+        VkPhysicalDeviceFeatures2 deviceFeatures2 = {};
+        deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        deviceFeatures2.pNext = &timelineFeatures;
+        void** next = &timelineFeatures.pNext;
+        if (config.bindless)
+        {
+            deviceFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+            deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+            *next = &indexingFeatures;
+            next = &indexingFeatures.pNext;
+        }
+        if (presentWaitEnabled)
+        {
+            *next = &presentFeatures.presentWait;
+            presentFeatures.presentWait.pNext = &presentFeatures.presentId;
+            next = &presentFeatures.presentId.pNext;
+        }
+        deviceFeatures2.features = deviceFeatures;
+        createInfo.pNext = &deviceFeatures2;
+
+        //启动交换链
+        auto extensions = getRequiredDeviceExtensions();
+        if (presentWaitEnabled)
+        {
+            auto presentExtensions = PresentLatency::requiredExtensions();
+            extensions.insert(extensions.end(), presentExtensions.begin(), presentExtensions.end());
+        }
+        //绘制数量由GPU写入时只执行可见物体的指令，不支持时退回到固定数量的间接绘制
+        drawIndirectCountEnabled = config.gpuCulling && GpuCulling::hasDrawIndirectCount(physicalDevice);
+        if (drawIndirectCountEnabled)
+        {
+            extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        //可以对设备和Vulkan实例使用相同校验层
+        if (enableValidationLayers)
+        {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
+            createInfo.ppEnabledLayerNames = validationLayers.data();
+        }
+        else
+        {
+            createInfo.enabledLayerCount = 0;
+        }
+
+        //调用vkCreateDevice创建逻辑设备,逻辑设备不直接与vk实例交互
+        if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS)
+        {
+            throw std::runtime_error("fialed to create logical device!");
+        }
+
+        vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
+        vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+        vkGetDeviceQueue(device, indices.computeFamily.value(), computeQueueIndex, &computeQueue);
+        vkGetDeviceQueue(device, indices.transferFamily.value(), transferQueueIndex, &transferQueue);
+        printf("queue families: graphics %u, present %u, compute %u (queue %u), transfer %u (queue %u)\n",
+            indices.graphicsFamily.value(), indices.presentFamily.value(), indices.computeFamily.value(),
+            computeQueueIndex, indices.transferFamily.value(), transferQueueIndex);
+    }
+
+    //同一个队列上的提交按顺序执行，它们共用一条时间线，值仍然按提交顺序递增
+    void createTimelines()
+    {
+        graphicsTimeline.init(device);
+        if (computeQueue != graphicsQueue)
+        {
+            computeTimeline.init(device);
+        }
+        if (transferQueue != graphicsQueue && transferQueue != computeQueue)
+        {
+            transferTimeline.init(device);
+        }
+    }
+
+    TimelineSemaphore& queueTimeline(VkQueue queue)
+    {
+        if (queue == computeQueue && queue != graphicsQueue)
+        {
+            return computeTimeline;
+        }
+        if (queue == transferQueue && queue != graphicsQueue)
+        {
+            return transferQueue == computeQueue ? computeTimeline : transferTimeline;
+        }
+        return graphicsTimeline;
+    }
+
+    void destroyTimelines()
+    {
+        transferTimeline.destroy();
+        computeTimeline.destroy();
+        graphicsTimeline.destroy();
+    }
+#pragma endregion
+
+#pragma region 窗口呈现
+    void createSurface()
+    {
+        if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create window surface");
+        }
+    }
+#pragma endregion
+
+#pragma region 交换链
+    //离屏模式不需要交换链扩展
+    std::vector<const char*> getRequiredDeviceExtensions()
+    {
+        if (config.headless)
+        {
+            return {};
+        }
+        return deviceExtensions;
+    }
+
+    bool checkDeviceExtensionSupport(VkPhysicalDevice device)
+    {
+        uint32_t extensionCount;
+        //查看设备支持的所有扩展
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        auto extensions = getRequiredDeviceExtensions();
+        std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
+
+        for (const auto& extension : availableExtensions)
+        {
+            requiredExtensions.erase(extension.extensionName);
+        }
+        /*在这里，我们将所需的扩展保存在一个集合中，然后枚举所有可用的扩展，将集合中的扩展剔除，
+        最后，如果这个集合中的元素为0，说明我们所需的扩展全部都被满足。*/
+        return requiredExtensions.empty();
+    }
+
+    //用于填写交换链细节结构体
+    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device)
+    {
+        SwapChainSupportDetails details;
+
+        //查询基础表面特征
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+        
+        //查询表面支持格式
+        uint32_t formatCount;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+        if (formatCount != 0)
+        {
+            details.formats.resize(formatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+        }
+
+        //查询呈现模式
+        uint32_t presentModeCount;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
+        if (presentModeCount != 0)
+        {
+            details.presentModes.resize(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+        }
+
+        return details;
+    }
+
+    //选择合适的表面格式
+    VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
+    {
+        //表明没有自己的首选格式,则直接返回我们设定的格式
+        if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED)
+        {
+            return { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+        }
+
+        //若返回了一个格式列表，则检查这个列表
+        for (const auto& availableFormat : availableFormats)
+        {
+            if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM &&
+                availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+            {
+                return availableFormat;
+            }
+        }
+
+        //如果没有找到，返回第一个
+        return availableFormats[0];
+    }
+
+    //选择呈现模式：命令行指定的模式不支持时退回到所有设备都支持的FIFO
+    VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes)
+    {
+        if (config.presentMode.has_value())
+        {
+            VkPresentModeKHR requested = config.presentMode.value();
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), requested) != availablePresentModes.end())
+            {
+                return requested;
+            }
+            printf("present mode %s not supported, using fifo\n", presentModeName(requested));
+            return VK_PRESENT_MODE_FIFO_KHR;
+        }
+
+        VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
+
+        for (const auto& availablePresentMode : availablePresentModes)
+        {
+            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+            {
+                //若满足三缓冲，则返回三缓冲模式，避免撕裂，延迟低
+                return availablePresentMode;
+            }
+            else if(availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+            {
+                bestMode = availablePresentMode;
+            }
+        }
+        return bestMode;
+    }
+
+    //选择交换范围,交换范围是交换链中图像的分辨率
+    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities)
+    {
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+        {
+            //Vulkan通过currentExtent成员变量来告知适合我们窗口的交换范围
+            return capabilities.currentExtent;
+        }
+        else
+        {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+
+            VkExtent2D actualExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+
+            //确保所得到的的交换范围处于min与max之间
+            actualExtent.width = std::max(capabilities.minImageExtent.width, 
+                std::min(capabilities.maxImageExtent.width, actualExtent.width));
+            actualExtent.height = std::max(capabilities.minImageExtent.height,
+                std::min(capabilities.maxImageExtent.height, actualExtent.height));
+            
+            return actualExtent;
+        }
+    }
+    //代码中max和min函数用于在允许的范围内选择交换范围的高度值和宽度值
+
+    //创建交换链
+    //oldSwapChain不为空时新交换链接替它，调用者在创建之后销毁旧交换链
+    void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE)
+    {
+        SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice);
+        
+        VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
+        VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+        VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
+
+        //默认使用交换链支持的最小图像个数+1的图像来实现三倍缓冲，也可以由命令行指定
+        uint32_t imageCount = config.swapchainImages > 0 ? config.swapchainImages
+            : swapChainSupport.capabilities.minImageCount + 1;
+        //clamp一下
+        imageCount = std::max(imageCount, swapChainSupport.capabilities.minImageCount);
+        if (swapChainSupport.capabilities.maxImageCount > 0 &&//max为0表示，内存可以满足的话，可以使用任意数量图像
+            imageCount > swapChainSupport.capabilities.maxImageCount)
+        {
+            imageCount = swapChainSupport.capabilities.maxImageCount;
+        }
+
+        VkSwapchainCreateInfoKHR createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        createInfo.surface = surface;
+        createInfo.minImageCount = imageCount;
+        createInfo.imageFormat = surfaceFormat.format;
+        createInfo.imageColorSpace = surfaceFormat.colorSpace;
+        createInfo.imageExtent = extent;
+        createInfo.imageArrayLayers = 1;//指定每个图像所包含的层次，通常为1
+        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        //需要指定在多个队列族使用交换链图像的方式，通过图形队列在交换链图像上进行绘制操作
+        //通过图像提交呈现队列来显示
+        QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+        uint32_t queueFamilyIndices[] = { (uint32_t)indices.graphicsFamily.value(), (uint32_t)indices.presentFamily.value() };
+        if (indices.graphicsFamily.value() != indices.presentFamily.value())
+        {
+            //协同模式
+            createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilyIndices;
+        }
+        else
+        {
+            createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.queueFamilyIndexCount = 0;
+            createInfo.pQueueFamilyIndices = nullptr;
+        }
+
+        createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+
+        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+
+        createInfo.presentMode = presentMode;
+        swapChainPresentMode = presentMode;
+        createInfo.clipped = VK_TRUE;
+
+        createInfo.oldSwapchain = oldSwapChain;
+
+        if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create swap chain");
+        }
+
+        //我们在创建交换链时填写createInfo中指定了minImageCount,事实上vk可能会创建更多的图像，所以这里显式查询，避免出错
+        vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr);
+        swapChainImages.resize(imageCount);
+        vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data());
+
+        //获取交换链图像格式和范围的句柄
+        swapChainImageFormat = surfaceFormat.format;
+        swapChainExtent = extent;
+    }
+
+    void createImageViews()
+    {
+        swapChainImageViews.resize(swapChainImages.size());
+
+        for (size_t i = 0; i < swapChainImages.size(); i++)
+        {
+            swapChainImageViews[i] = createImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+        }
+    }
+
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+    {
+        VkImageViewCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        createInfo.image = image;
+
+        //viewType成员变量指定图像被看作是一维纹理、二维纹理、三维纹理还是立方体贴图
+        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        createInfo.format = format;
+
+        //components成员变量用于进行图像颜色通道的映射,这里使用默认
+        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+        //subresourceRange成员变量用于指定图像的用途和图像的哪一部分可以被访问
+        createInfo.subresourceRange.aspectMask = aspectFlags;
+        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.levelCount = 1;
+        createInfo.subresourceRange.baseArrayLayer = 0;
+        createInfo.subresourceRange.layerCount = 1;
+
+        VkImageView imageView;
+        if (vkCreateImageView(device, &createInfo, nullptr, &imageView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create image views");
+        }
+
+        return imageView;
+    }
+
+    //重建交换链
+    //只重建和交换链范围有关的对象：交换链、图像视图和帧缓冲。
+    //视口和裁剪是动态状态，渲染流程和管线只在图像格式变化时才重建
+    void recreateSwapChain()
+    {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        //窗口最小化时等到它恢复
+        while (width == 0 || height == 0)
+        {
+            glfwWaitEvents();
+            glfwGetFramebufferSize(window, &width, &height);
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        //只需要等图形队列上已经提交的绘制完成，旧的图像视图和帧缓冲就不再被使用，上传队列不受影响
+        graphicsTimeline.wait(graphicsTimeline.getPendingValue());
+
+        //热重载的后台线程不能在渲染流程被替换时创建管线，渲染图引用旧的图像视图，先释放它的渲染流程和帧缓冲
+        std::lock_guard<std::mutex> buildLock(pipelineBuildMutex);
+        renderGraph.reset();
+        for (auto imageView : swapChainImageViews)
+        {
+            vkDestroyImageView(device, imageView, nullptr);
+        }
+
+        //把旧交换链交给新交换链，呈现引擎可以复用它的资源，已经排队的呈现照常完成
+        VkFormat oldFormat = swapChainImageFormat;
+        VkSwapchainKHR oldSwapChain = swapChain;
+        createSwapChain(oldSwapChain);
+        vkDestroySwapchainKHR(device, oldSwapChain, nullptr);
+        presentLatency.reset();
+        createImageViews();
+
+        //图像格式不变时新的渲染流程和旧的兼容，管线可以继续使用；否则已经创建好但还没换上的管线属于旧的渲染流程，直接丢弃
+        buildRenderGraph();
+        bool pipelineRebuilt = swapChainImageFormat != oldFormat;
+        if (pipelineRebuilt)
+        {
+            {
+                std::lock_guard<std::mutex> lock(reloadMutex);
+                if (pendingGraphicsPipeline != VK_NULL_HANDLE)
+                {
+                    vkDestroyPipeline(device, pendingGraphicsPipeline, nullptr);
+                    pendingGraphicsPipeline = VK_NULL_HANDLE;
+                }
+                if (pendingDepthPipeline != VK_NULL_HANDLE)
+                {
+                    vkDestroyPipeline(device, pendingDepthPipeline, nullptr);
+                    pendingDepthPipeline = VK_NULL_HANDLE;
+                }
+            }
+            vkDestroyPipeline(device, graphicsPipeline, nullptr);
+            vkDestroyPipeline(device, depthPipeline, nullptr);
+            vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+            createGraphicsPipeline();
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        printf("resize: %ux%u in %.3f ms%s\n", swapChainExtent.width, swapChainExtent.height,
+            std::chrono::duration<double, std::milli>(endTime - startTime).count(),
+            pipelineRebuilt ? " (image format changed, pipeline rebuilt)" : "");
+    }
+
+    //一帧之间收到的多次大小变化只处理一次，大小和当前交换链一致时不重建，除非呈现时报告了交换链不够理想
+    void handlePendingResize()
+    {
+        if (!framebufferResized && !swapChainSuboptimal)
+        {
+            return;
+        }
+
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (swapChainSuboptimal ||
+            static_cast<uint32_t>(width) != swapChainExtent.width || static_cast<uint32_t>(height) != swapChainExtent.height)
+        {
+            recreateSwapChain();
+        }
+        framebufferResized = false;
+        swapChainSuboptimal = false;
+    }
+
+    void cleanupSwapChain()
+    {
+        renderGraph.destroy();
+
+        vkDestroyPipeline(device, graphicsPipeline, nullptr);
+        vkDestroyPipeline(device, depthPipeline, nullptr);
+
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+
+        for (auto imageView : swapChainImageViews)
+        {
+            vkDestroyImageView(device, imageView, nullptr);
+        }
+
+        if (config.headless)
+        {
+            cleanupOffscreenTargets();
+        }
+        else
+        {
+            vkDestroySwapchainKHR(device, swapChain, nullptr);
+        }
+    }
+#pragma endregion
+
+#pragma region 离屏渲染
+    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
+        VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, Allocation& imageAllocation)
+    {
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = width;
+        imageInfo.extent.height = height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = tiling;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+        {
+            LOG_ERROR("failed to create image");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+        //线性排列的图像和缓冲一样按线性资源处理
+        AllocationType type = tiling == VK_IMAGE_TILING_LINEAR ? AllocationType::Linear : AllocationType::Optimal;
+        imageAllocation = allocator.allocate(memRequirements, properties, type);
+
+        vkBindImageMemory(device, image, imageAllocation.memory, imageAllocation.offset);
+    }
+
+    //离屏模式下的渲染目标，每个并行帧一张图像，这样CPU录制下一帧时GPU可以继续渲染上一帧
+    void createOffscreenTargets()
+    {
+        swapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        swapChainExtent = { config.width, config.height };
+
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (config.readback)
+        {
+            usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
+        swapChainImages.resize(config.framesInFlight);
+        swapChainImageViews.resize(config.framesInFlight);
+        offscreenImagesAllocation.resize(config.framesInFlight);
+
+        for (size_t i = 0; i < swapChainImages.size(); i++)
+        {
+            createImage(swapChainExtent.width, swapChainExtent.height, swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+                usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], offscreenImagesAllocation[i]);
+            swapChainImageViews[i] = createImageView(swapChainImages[i], swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+        }
+
+        if (!config.readback)
+        {
+            return;
+        }
+
+        //回读缓冲使用主机一致的内存，映射后直接读取，不需要手动invalidate
+        VkDeviceSize readbackSize = static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4;
+        readbackBuffers.resize(swapChainImages.size());
+        readbackBuffersAllocation.resize(swapChainImages.size());
+        readbackPending.assign(swapChainImages.size(), false);
+
+        for (size_t i = 0; i < swapChainImages.size(); i++)
+        {
+            createBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                readbackBuffers[i], readbackBuffersAllocation[i]);
+        }
+    }
+
+    void cleanupOffscreenTargets()
+    {
+        for (size_t i = 0; i < swapChainImages.size(); i++)
+        {
+            vkDestroyImage(device, swapChainImages[i], nullptr);
+            allocator.free(offscreenImagesAllocation[i]);
+        }
+
+        for (size_t i = 0; i < readbackBuffers.size(); i++)
+        {
+            destroyBuffer(readbackBuffers[i], readbackBuffersAllocation[i]);
+        }
+        readbackBuffers.clear();
+        readbackBuffersAllocation.clear();
+    }
+
+    //渲染图中的回读pass：把图像拷贝到回读缓冲，场景pass的渲染流程已经把图像转换为传输源布局，
+    //拷贝结果对主机可见的屏障由渲染图在一帧的最后录制
+    void recordReadback(VkCommandBuffer commandBuffer, size_t imageIndex)
+    {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0; //0表示紧密排列
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+
+        vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            readbackBuffers[imageIndex], 1, &region);
+    }
+
+    //把已经完成的一帧从回读缓冲取回到主机内存，调用前必须已经等到这一帧上次提交的时间线值
+    void collectReadback(uint32_t imageIndex)
+    {
+        if (!readbackPending[imageIndex])
+        {
+            return;
+        }
+
+        size_t size = static_cast<size_t>(swapChainExtent.width) * swapChainExtent.height * 4;
+        readbackPixels.resize(size);
+        memcpy(readbackPixels.data(), readbackBuffersAllocation[imageIndex].mapped, size);
+        readbackPending[imageIndex] = false;
+    }
+
+    //把回读的像素写成ppm文件，方便和其他版本的结果比较
+    void writeReadbackFile(const std::string& filename)
+    {
+        if (readbackPixels.empty())
+        {
+            return;
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open readback file");
+        }
+
+        file << "P6\n" << swapChainExtent.width << " " << swapChainExtent.height << "\n255\n";
+        for (size_t i = 0; i < readbackPixels.size(); i += 4)
+        {
+            file.write(reinterpret_cast<const char*>(&readbackPixels[i]), 3);
+        }
+    }
+
+    //离屏模式的主循环：固定渲染config.frameCount帧，并统计帧时间
+    void offscreenLoop()
+    {
+        std::vector<double> frameTimes;
+        frameTimes.reserve(config.frameCount);
+
+        auto loopStart = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < config.frameCount; i++)
+        {
+            frameLimiter.wait();
+            auto start = std::chrono::high_resolution_clock::now();
+            drawOffscreenFrame();
+            auto end = std::chrono::high_resolution_clock::now();
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        runStats.frames = config.frameCount;
+
+        vkDeviceWaitIdle(device);
+        finishRunStats(loopStart);
+
+        if (config.readback)
+        {
+            //按提交顺序取回剩下的帧，最后提交的一帧最后取回
+            for (size_t i = 0; i < config.framesInFlight; i++)
+            {
+                collectReadback(static_cast<uint32_t>((currentFrame + i) % config.framesInFlight));
+            }
+
+            if (!config.readbackFile.empty())
+            {
+                writeReadbackFile(config.readbackFile);
+            }
+        }
+
+        if (frameTimes.empty())
+        {
+            return;
+        }
+
+        double total = 0.0;
+        double minTime = frameTimes[0];
+        double maxTime = frameTimes[0];
+        for (double t : frameTimes)
+        {
+            total += t;
+            minTime = std::min(minTime, t);
+            maxTime = std::max(maxTime, t);
+        }
+        double average = total / frameTimes.size();
+
+        printf("headless: %u frames %ux%u, avg %.3f ms, min %.3f ms, max %.3f ms, fps %.1f\n",
+            config.frameCount, swapChainExtent.width, swapChainExtent.height,
+            average, minTime, maxTime, 1000.0 / average);
+        printf("render queue: %llu binds recorded, %llu redundant binds skipped\n",
+            static_cast<unsigned long long>(recordedBinds.load()), static_cast<unsigned long long>(skippedBinds.load()));
+        exportTiming();
+#ifndef NDEBUG
+        allocator.printStats();
+#endif
+    }
+#pragma endregion
+
+#pragma region 渲染设置
+    //深度缓冲的格式：依次选择设备支持作为深度附着的格式，不使用模板，32位浮点的精度最高
+    VkFormat findDepthFormat()
+    {
+        const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT,
+            VK_FORMAT_D16_UNORM };
+        for (VkFormat format : candidates)
+        {
+            VkFormatProperties formatProperties;
+            vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+            if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+            {
+                return format;
+            }
+        }
+        throw std::runtime_error("failed to find a supported depth format");
+    }
+
+    //带模板的格式作为附着时视图要包含两个方面
+    static VkImageAspectFlags depthAspect(VkFormat format)
+    {
+        if (format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT)
+        {
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    }
+
+    //声明一帧的渲染图：GPU剔除(可选)、深度预通道(可选)、场景、回读(离屏模式可选)，之间的屏障和布局转换由渲染图生成。
+    //场景pass的附着按交换链图像或离屏图像的数量各有一个帧缓冲，交换链变化后重新声明
+    void buildRenderGraph()
+    {
+        renderGraph.reset();
+
+        //交换链图像最后转换为呈现布局，呈现之前的同步由信号量保证；离屏图像每帧都被清除，最后的布局不需要转换
+        RenderGraph::ResourceHandle backbuffer = renderGraph.importImage("backbuffer", swapChainImageFormat,
+            swapChainExtent, VK_IMAGE_ASPECT_COLOR_BIT, swapChainImages, swapChainImageViews, VK_IMAGE_LAYOUT_UNDEFINED,
+            config.headless ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        renderGraph.markOutput(backbuffer);
+        //深度缓冲只在一帧之内使用，场景pass之后内容不再需要
+        RenderGraph::ResourceHandle depth = renderGraph.createImage("depth", depthFormat, swapChainExtent,
+            depthAspect(depthFormat));
+
+        //剔除输出按并行帧各一份，渲染图只跟踪这一帧使用的那一份
+        RenderGraph::ResourceHandle cullOutput = 0;
+        if (config.gpuCulling)
+        {
+            cullOutput = renderGraph.importBuffer("cull output");
+            RenderGraph::PassHandle cullPass = renderGraph.addPass("cull", RenderGraph::PassType::Compute,
+                [this](VkCommandBuffer commandBuffer, const RenderGraph::PassContext&) {
+                    gpuCulling.recordCull(commandBuffer, static_cast<uint32_t>(currentFrame), cullParams);
+                });
+            renderGraph.writeBuffer(cullPass, cullOutput, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+        }
+
+        //深度预通道先写入完整的深度，场景pass保留它
+        if (config.depthPrepass)
+        {
+            depthPrepassPass = renderGraph.addPass("depth prepass", RenderGraph::PassType::Graphics,
+                [this](VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context) {
+                    recordScene(commandBuffer, context, true);
+                });
+            renderGraph.setContents(depthPrepassPass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            renderGraph.writeDepth(depthPrepassPass, depth, VK_ATTACHMENT_LOAD_OP_CLEAR);
+            if (config.gpuCulling)
+            {
+                renderGraph.readBuffer(depthPrepassPass, cullOutput, GpuCulling::OUTPUT_STAGES, GpuCulling::OUTPUT_ACCESS);
+            }
+        }
+
+        //场景中的指令全部来自次级指令缓冲
+        scenePass = renderGraph.addPass("scene", RenderGraph::PassType::Graphics,
+            [this](VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context) {
+                recordScene(commandBuffer, context, false);
+            });
+        renderGraph.setContents(scenePass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } }; //每次渲染新的一帧前使用黑色清除帧缓冲
+        renderGraph.writeColor(scenePass, backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, clearColor);
+        renderGraph.writeDepth(scenePass, depth, config.depthPrepass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR);
+        if (config.gpuCulling)
+        {
+            renderGraph.readBuffer(scenePass, cullOutput, GpuCulling::OUTPUT_STAGES, GpuCulling::OUTPUT_ACCESS);
+        }
+
+        //回读缓冲在这一帧完成后由主机读取
+        if (config.headless && config.readback)
+        {
+            RenderGraph::ResourceHandle readback = renderGraph.importBuffer("readback", VK_PIPELINE_STAGE_HOST_BIT,
+                VK_ACCESS_HOST_READ_BIT);
+            renderGraph.markOutput(readback);
+            RenderGraph::PassHandle readbackPass = renderGraph.addPass("readback", RenderGraph::PassType::Transfer,
+                [this](VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context) {
+                    recordReadback(commandBuffer, context.imageIndex);
+                });
+            renderGraph.readImage(readbackPass, backbuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+            renderGraph.writeBuffer(readbackPass, readback, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        }
+
+        renderGraph.compile();
+        renderPass = renderGraph.getRenderPass(scenePass);
+        depthRenderPass = config.depthPrepass ? renderGraph.getRenderPass(depthPrepassPass) : VK_NULL_HANDLE;
+    }
+
+    //实例化绘制使用从逐实例顶点流读取变换的顶点着色器，无绑定模式从存储缓冲中读取
+    std::string vertexShaderSource() const
+    {
+        if (config.bindless)
+        {
+            return "./shader/shader_bindless.vert";
+        }
+        if (usesPushConstants())
+        {
+            return "./shader/shader_push.vert";
+        }
+        return config.instanced ? "./shader/shader_base_instanced.vert" : "./shader/shader_base.vert";
+    }
+
+    std::string vertexShaderPath() const
+    {
+        if (config.bindless)
+        {
+            return "./shader/shader_bindless_v.spv";
+        }
+        if (usesPushConstants())
+        {
+            return "./shader/shader_push_v.spv";
+        }
+        return config.instanced ? "./shader/shader_base_instanced_v.spv" : "./shader/shader_base_v.spv";
+    }
+
+    //深度预通道的顶点着色器和对应的颜色着色器使用相同的输入和变换，只读取位置
+    std::string depthShaderSource() const
+    {
+        if (config.bindless)
+        {
+            return "./shader/shader_depth_bindless.vert";
+        }
+        if (usesPushConstants())
+        {
+            return "./shader/shader_depth_push.vert";
+        }
+        return config.instanced ? "./shader/shader_depth_instanced.vert" : "./shader/shader_depth.vert";
+    }
+
+    std::string depthShaderPath() const
+    {
+        if (config.bindless)
+        {
+            return "./shader/shader_depth_bindless_v.spv";
+        }
+        if (usesPushConstants())
+        {
+            return "./shader/shader_depth_push_v.spv";
+        }
+        return config.instanced ? "./shader/shader_depth_instanced_v.spv" : "./shader/shader_depth_v.spv";
+    }
+
+    //无绑定模式的片元着色器从图像数组中采样纹理
+    std::string fragmentShaderSource() const
+    {
+        return config.bindless ? "./shader/shader_bindless.frag" : "./shader/shader_base.frag";
+    }
+
+    std::string fragmentShaderPath() const
+    {
+        return config.bindless ? "./shader/shader_bindless_f.spv" : "./shader/shader_base_f.spv";
+    }
+
+    void createGraphicsPipeline()
+    {
+        createPipelineLayout();
+        graphicsPipeline = buildGraphicsPipeline(readFile(vertexShaderPath()), readFile(fragmentShaderPath()),
+            pipelineCreateTime);
+        if (config.depthPrepass)
+        {
+            double depthCreateMs = 0.0;
+            depthPipeline = buildGraphicsPipeline(readFile(depthShaderPath()), {}, depthCreateMs, true);
+            pipelineCreateTime += depthCreateMs;
+        }
+    }
+
+    //管线布局只取决于描述符布局，着色器热重载时保持不变
+    void createPipelineLayout()
+    {
+        std::vector<VkDescriptorSetLayout> setLayouts = { descriptorSetLayout };
+        if (config.bindless)
+        {
+            setLayouts.push_back(bindless.getLayout());
+        }
+
+        VkPipelineLayoutCreateInfo  pipelineLayoutInfo = {};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+
+        //逐绘制的数据只在顶点着色器中使用
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DrawPushConstants);
+        if (usesPushConstants())
+        {
+            pipelineLayoutInfo.pushConstantRangeCount = 1;
+            pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        }
+        else
+        {
+            pipelineLayoutInfo.pushConstantRangeCount = 0;
+            pipelineLayoutInfo.pPushConstantRanges = nullptr;
+        }
+
+        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline layout");
+        }
+    }
+
+    //创建图形管线，只读取渲染流程、管线布局和网格的顶点格式，热重载时在后台线程上调用。
+    //depthOnly时创建深度预通道的管线：没有片元着色器，只读取位置流，按深度预通道的渲染流程创建。
+    //createMs返回vkCreateGraphicsPipelines本身的耗时
+    VkPipeline buildGraphicsPipeline(const std::vector<char>& vertShaderCode, const std::vector<char>& fragShaderCode,
+        double& createMs, bool depthOnly = false)
+    {
+        //可编程管线设置
+        //着色器模块对象只在管线创建时需要，所以定义成局部变量即可
+        VkShaderModule vertShaderModule;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+
+        vertShaderModule = createShaderModule(vertShaderCode);
+        if (!depthOnly)
+        {
+            try {
+                fragShaderModule = createShaderModule(fragShaderCode);
+            }
+            catch (...) {
+                vkDestroyShaderModule(device, vertShaderModule, nullptr);
+                throw;
+            }
+        }
+
+        //vkShaderModule只是对着色器字节码的包装，我们还需要指定它们在管线的哪一阶段被使用
+        VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
+        vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+        vertShaderStageInfo.module = vertShaderModule;
+        vertShaderStageInfo.pName = "main";
+
+        //量化的位置在顶点着色器中乘以positionScale还原，浮点格式时为1
+        VkSpecializationMapEntry positionScaleEntry = {};
+        positionScaleEntry.constantID = 0;
+        positionScaleEntry.offset = 0;
+        positionScaleEntry.size = sizeof(float);
+
+        VkSpecializationInfo vertSpecialization = {};
+        vertSpecialization.mapEntryCount = 1;
+        vertSpecialization.pMapEntries = &positionScaleEntry;
+        vertSpecialization.dataSize = sizeof(float);
+        vertSpecialization.pData = &meshPositionScale;
+        vertShaderStageInfo.pSpecializationInfo = &vertSpecialization;
+
+        VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
+        fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        fragShaderStageInfo.module = fragShaderModule;
+        fragShaderStageInfo.pName = "main";
+
+        VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+
+        //管线固定功能设置
+        //1：顶点输入
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        //绑定0是逐顶点的网格数据(深度预通道只有位置)，实例化绘制时绑定1是逐实例的数据，无绑定模式下实例数据不经过顶点输入
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+        if (depthOnly && meshQuantized)
+        {
+            auto vertexAttributes = VertexLayout<PackedPositionVertex>::attributeDescriptions(0);
+            bindingDescriptions.push_back(VertexLayout<PackedPositionVertex>::bindingDescription(0));
+            attributeDescriptions.assign(vertexAttributes.begin(), vertexAttributes.end());
+        }
+        else if (depthOnly)
+        {
+            auto vertexAttributes = VertexLayout<PositionVertex>::attributeDescriptions(0);
+            bindingDescriptions.push_back(VertexLayout<PositionVertex>::bindingDescription(0));
+            attributeDescriptions.assign(vertexAttributes.begin(), vertexAttributes.end());
+        }
+        else if (meshQuantized)
+        {
+            auto vertexAttributes = VertexLayout<PackedVertex>::attributeDescriptions(0);
+            bindingDescriptions.push_back(VertexLayout<PackedVertex>::bindingDescription(0));
+            attributeDescriptions.assign(vertexAttributes.begin(), vertexAttributes.end());
+        }
+        else
+        {
+            auto vertexAttributes = VertexLayout<Vertex>::attributeDescriptions(0);
+            bindingDescriptions.push_back(VertexLayout<Vertex>::bindingDescription(0));
+            attributeDescriptions.assign(vertexAttributes.begin(), vertexAttributes.end());
+        }
+        if (config.instanced && !config.bindless)
+        {
+            //每个实例前进一次，而不是每个顶点
+            bindingDescriptions.push_back(VertexLayout<InstanceData>::bindingDescription(1, VK_VERTEX_INPUT_RATE_INSTANCE));
+            auto instanceAttributes = VertexLayout<InstanceData>::attributeDescriptions(1);
+            attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+        }
+
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+        //2：输入装配，图元组装阶段
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        //3：视口和裁剪，都是动态状态，录制时按当前的交换链范围设置，窗口大小改变时管线不需要重建
+        VkPipelineViewportStateCreateInfo viewportState = {};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.pViewports = nullptr;
+        viewportState.scissorCount = 1;
+        viewportState.pScissors = nullptr;
+
+        //4：光栅化
+        VkPipelineRasterizationStateCreateInfo rasterizer = {};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+        rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterizer.depthBiasEnable = VK_FALSE;
+        rasterizer.depthBiasConstantFactor = 0.0f;
+        rasterizer.depthBiasClamp = 0.0f;
+        rasterizer.depthBiasSlopeFactor = 0.0f;
+
+        //5：多重采样
+        VkPipelineMultisampleStateCreateInfo multisampling = {};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisampling.minSampleShading = 1.0f;
+        multisampling.pSampleMask = nullptr;
+        multisampling.alphaToCoverageEnable = VK_FALSE;
+        multisampling.alphaToOneEnable = VK_FALSE;
+
+        //6：深度测试，不使用模板。有深度预通道时深度已经写好，颜色pass只通过深度相等的片元，不再写入深度；
+        //两个管线的顶点着色器用同样的表达式计算位置，并且都把gl_Position声明为invariant，
+        //分别编译的程序也保证得到相同的深度值
+        VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = VK_TRUE;
+        depthStencil.depthWriteEnable = depthOnly || !config.depthPrepass ? VK_TRUE : VK_FALSE;
+        depthStencil.depthCompareOp = depthOnly || !config.depthPrepass ? VK_COMPARE_OP_LESS : VK_COMPARE_OP_LESS_OR_EQUAL;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.stencilTestEnable = VK_FALSE;
+        depthStencil.minDepthBounds = 0.0f;
+        depthStencil.maxDepthBounds = 1.0f;
+
+        //7：颜色混合
+        VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_FALSE;
+        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending = {};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable = VK_FALSE;
+        colorBlending.logicOp = VK_LOGIC_OP_COPY;
+        colorBlending.attachmentCount = depthOnly ? 0 : 1; //深度预通道没有颜色附着
+        colorBlending.pAttachments = &colorBlendAttachment;
+        colorBlending.blendConstants[0] = 0.0f;
+        colorBlending.blendConstants[1] = 0.0f;
+        colorBlending.blendConstants[2] = 0.0f;
+        colorBlending.blendConstants[3] = 0.0f;
+
+        //8：动态状态,指定需要动态修改的状态
+        VkDynamicState dynamicStates[] = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR
+        };
+        VkPipelineDynamicStateCreateInfo dynamicState = {};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = {};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        //引入着色器阶段
+        pipelineInfo.stageCount = depthOnly ? 1 : 2;
+        pipelineInfo.pStages = shaderStages;
+        //引入固定管线阶段
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pDepthStencilState = &depthStencil;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        //指定管线布局
+        pipelineInfo.layout = pipelineLayout;
+        //引入渲染流程对象和子流程在子流程数组中的索引
+        pipelineInfo.renderPass = depthOnly ? depthRenderPass : renderPass;
+        pipelineInfo.subpass = 0;
+
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+
+        //管线缓存命中时驱动可以跳过着色器编译
+        auto startTime = std::chrono::high_resolution_clock::now();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult result = vkCreateGraphicsPipelines(device, pipelineCache.getCache(), 1, &pipelineInfo, nullptr, &pipeline);
+        auto endTime = std::chrono::high_resolution_clock::now();
+        createMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+        if (fragShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(device, fragShaderModule, nullptr);
+        }
+        vkDestroyShaderModule(device, vertShaderModule, nullptr);
+
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline");
+        }
+        return pipeline;
+    }
+
+    VkShaderModule createShaderModule(const std::vector<char>& code)
+    {
+        VkShaderModuleCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size();
+        //先要将存储的字节码的数组指针转换为const uint32_t*的变量类型
+        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shdaer module");
+        }
+
+        return shaderModule;
+    }
+
+    //数据上传使用传输队列族自己的指令池，由UploadManager管理
+    void createUploadManager()
+    {
+        QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+
+        uploadManager.init(device, allocator, queueFamilyIndices.transferFamily.value(), transferQueue,
+            queueTimeline(transferQueue), queueFamilyIndices.graphicsFamily.value());
+
+        #ifndef NDEBUG
+        std::cout << "upload queue family " << queueFamilyIndices.transferFamily.value()
+            << (uploadManager.usesOwnershipTransfer() ? " (dedicated transfer)" : " (graphics)") << std::endl;
+        #endif // !NDEBUG
+    }
+
+    //把上传批次的acquire屏障录制到这一帧的主指令缓冲开头，并记下图形提交需要等待的时间线值
+    void recordUploadAcquire(VkCommandBuffer commandBuffer)
+    {
+        uploadWaitSemaphores.clear();
+        uploadWaitValues.clear();
+        uploadWaitStages.clear();
+
+        std::vector<VkBufferMemoryBarrier> barriers;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        VkPipelineStageFlags dstStages = 0;
+        uploadManager.takePendingAcquire(barriers, imageBarriers, dstStages, uploadWaitSemaphores, uploadWaitValues,
+            uploadWaitStages);
+        if (barriers.empty() && imageBarriers.empty())
+        {
+            return;
+        }
+
+        //信号量在dstStages处等待，屏障的第一个同步范围也从这些阶段开始，保证acquire在传输完成之后
+        vkCmdPipelineBarrier(commandBuffer, dstStages, dstStages, 0,
+            0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(),
+            static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    //每个并行帧一个指令池和一个主指令缓冲，另外每个录制线程各一个指令池。指令池使用TRANSIENT标记，
+    //每帧开始时整个重置，这样每帧重新录制指令的开销很小，场景变化时也不需要释放重建指令缓冲
+    void createFrameResources()
+    {
+        QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+
+        uint32_t workerCount = config.threadCount;
+        if (workerCount == 0)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threadPool = std::make_unique<ThreadPool>(workerCount);
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        frames.resize(config.framesInFlight);
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &frames[i].commandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create frame command pool");
+            }
+
+            frames[i].workerPools.resize(workerCount);
+            for (auto& workerPool : frames[i].workerPools)
+            {
+                if (vkCreateCommandPool(device, &poolInfo, nullptr, &workerPool.commandPool) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create worker command pool");
+                }
+            }
+
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = frames[i].commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device, &allocInfo, &frames[i].commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate command buffers");
+            }
+        }
+    }
+
+    void cleanupFrameResources()
+    {
+        for (auto& frameResources : frames)
+        {
+            //销毁指令池时其中分配的指令缓冲一同释放
+            vkDestroyCommandPool(device, frameResources.commandPool, nullptr);
+            for (auto& workerPool : frameResources.workerPools)
+            {
+                vkDestroyCommandPool(device, workerPool.commandPool, nullptr);
+            }
+            vkDestroySemaphore(device, frameResources.renderFinishedSemaphore, nullptr);
+            vkDestroySemaphore(device, frameResources.imageAvailableSemaphore, nullptr);
+        }
+        frames.clear();
+        threadPool.reset();
+    }
+
+    //GPU已经执行完这一帧上次提交的指令后调用，重置主指令池和所有录制线程的指令池
+    void resetFrameCommandPools(FrameResources& frameResources)
+    {
+        vkResetCommandPool(device, frameResources.commandPool, 0);
+        for (auto& workerPool : frameResources.workerPools)
+        {
+            vkResetCommandPool(device, workerPool.commandPool, 0);
+            workerPool.usedCount = 0;
+        }
+    }
+
+    //从录制线程自己的指令池中取一个次级指令缓冲，不够时再分配
+    VkCommandBuffer acquireSecondaryCommandBuffer(WorkerCommandPool& workerPool)
+    {
+        if (workerPool.usedCount == workerPool.secondaryBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = workerPool.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate secondary command buffer");
+            }
+            workerPool.secondaryBuffers.push_back(commandBuffer);
+        }
+        return workerPool.secondaryBuffers[workerPool.usedCount++];
+    }
+
+    //在录制线程上把排序后[firstObject, lastObject)范围内的绘制包录制到一个次级指令缓冲，
+    //同时写入这些物体的uniform数据或实例数据，它们在环形缓冲中预留的位置互不重叠。
+    //第k个绘制包的数据写在第k个位置上，深度预通道和场景pass的绘制包顺序相同，所以位置也相同
+    VkCommandBuffer recordDrawRange(WorkerCommandPool& workerPool, const RenderGraph::PassContext& context,
+        const RenderQueue::DrawPacket* packets, uint32_t firstObject, uint32_t lastObject, uint32_t uniformBase,
+        bool depthOnly)
+    {
+        VkCommandBuffer commandBuffer = acquireSecondaryCommandBuffer(workerPool);
+
+        //次级指令缓冲在渲染流程内执行，需要继承渲染流程和帧缓冲信息
+        VkCommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = context.renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = context.framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording secondary command buffer");
+        }
+
+        //管线、描述符集和顶点缓冲都通过它绑定，和当前状态相同的绑定不再录制
+        BindingCache bindings(commandBuffer);
+
+        //动态状态不会从主指令缓冲继承，每个次级指令缓冲都要设置
+        //交换链图像大小可能与窗口大小不同，所以视口和裁剪范围都使用交换链图像的大小
+        VkViewport viewport = {};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = (float)swapChainExtent.width;
+        viewport.height = (float)swapChainExtent.height;
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor = {};
+        scissor.offset = { 0, 0 };
+        scissor.extent = swapChainExtent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        //深度预通道只读取位置流
+        bindings.bindVertexBuffer(0, vertexBuffer, depthOnly ? meshPositionOffset : 0);
+
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, meshIndexType);
+
+        //GPU剔除的绘制不经过渲染队列，管线直接按pass选择
+        if (config.gpuCulling)
+        {
+            bindings.bindPipeline(depthOnly ? depthPipeline : graphicsPipeline);
+        }
+
+        //逐物体的数据在这一帧第一次绘制时写入，有深度预通道时颜色pass直接使用它写好的数据
+        bool writeData = depthOnly || !config.depthPrepass;
+        if (config.bindless)
+        {
+            recordBindlessDraws(bindings, packets, firstObject, lastObject, uniformBase, writeData);
+        }
+        else if (config.gpuCulling)
+        {
+            //实例数据和绘制指令都已经由这一帧的剔除计算写好
+            bindings.bindVertexBuffer(1, gpuCulling.getInstanceBuffer(static_cast<uint32_t>(currentFrame)), 0);
+            bindings.bindDescriptorSet(pipelineLayout, 0, descriptorSet, 1, &uniformBase);
+            gpuCulling.recordDraw(commandBuffer, static_cast<uint32_t>(currentFrame));
+        }
+        else if (config.instanced)
+        {
+            //按绘制顺序写入这一段物体的实例数据
+            if (writeData)
+            {
+                InstanceData* instances = static_cast<InstanceData*>(instanceRing.getMapped(instanceBase));
+                for (uint32_t i = firstObject; i < lastObject; i++)
+                {
+                    writeInstanceData(sceneObjects[packets[i].object], instances[i]);
+                }
+            }
+
+            bindings.bindVertexBuffer(1, instanceRing.getBuffer(), instanceBase);
+            //uniformBase指向这一帧共用的观察和投影矩阵
+            bindings.bindDescriptorSet(pipelineLayout, 0, descriptorSet, 1, &uniformBase);
+            recordInstanceBatches(bindings, packets, firstObject, lastObject);
+        }
+        else if (usesPushConstants())
+        {
+            recordPushConstantDraws(bindings, packets, firstObject, lastObject, uniformBase);
+        }
+        else
+        {
+            recordObjectDraws(bindings, packets, firstObject, lastObject, uniformBase, writeData);
+        }
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record secondary command buffer");
+        }
+        recordedBinds.fetch_add(bindings.getRecorded(), std::memory_order_relaxed);
+        skippedBinds.fetch_add(bindings.getSkipped(), std::memory_order_relaxed);
+        return commandBuffer;
+    }
+
+    //绘制包的排序键中管线字段对应的管线
+    VkPipeline queuePipeline(uint64_t key) const
+    {
+        return RenderQueue::pipelineOf(key) == QueuePipelineDepth ? depthPipeline : graphicsPipeline;
+    }
+
+    //排序之后状态相同(管线和材质都相同)的绘制包连续存放，一段这样的绘制包是一次实例化绘制。
+    //材质目前没有自己的GPU状态，只决定分段
+    void recordInstanceBatches(BindingCache& bindings, const RenderQueue::DrawPacket* packets, uint32_t firstObject,
+        uint32_t lastObject)
+    {
+        uint32_t first = firstObject;
+        while (first < lastObject)
+        {
+            uint64_t state = RenderQueue::stateOf(packets[first].key);
+            uint32_t last = first + 1;
+            while (last < lastObject && RenderQueue::stateOf(packets[last].key) == state)
+            {
+                last++;
+            }
+            bindings.bindPipeline(queuePipeline(packets[first].key));
+            drawInstanceBatch(bindings.getCommandBuffer(), { first, last - first });
+            first = last;
+        }
+    }
+
+    //提交一批实例，调用前需要绑定好网格和实例缓冲
+    void drawInstanceBatch(VkCommandBuffer commandBuffer, const InstanceBatch& batch)
+    {
+        if (batch.instanceCount == 0)
+        {
+            return;
+        }
+        vkCmdDrawIndexed(commandBuffer, meshIndexCount, batch.instanceCount, 0, 0,
+            batch.firstInstance);
+    }
+
+    //无绑定模式：两个描述符集在整段开始时绑定一次，物体通过firstInstance(即gl_InstanceIndex)找到自己的实例数据
+    void recordBindlessDraws(BindingCache& bindings, const RenderQueue::DrawPacket* packets, uint32_t firstObject,
+        uint32_t lastObject, uint32_t uniformBase, bool writeData)
+    {
+        VkCommandBuffer commandBuffer = bindings.getCommandBuffer();
+        bindings.bindDescriptorSet(pipelineLayout, 0, descriptorSet, 1, &uniformBase);
+        bindings.bindDescriptorSet(pipelineLayout, BINDLESS_SET, bindless.getSet());
+
+        if (config.gpuCulling)
+        {
+            //剔除写入的实例缓冲已经注册为这一帧的句柄，间接绘制指令中的firstInstance指向可见物体
+            gpuCulling.recordDraw(commandBuffer, static_cast<uint32_t>(currentFrame));
+            return;
+        }
+
+        if (writeData)
+        {
+            InstanceData* instances = static_cast<InstanceData*>(instanceRing.getMapped(instanceBase));
+            for (uint32_t i = firstObject; i < lastObject; i++)
+            {
+                writeInstanceData(sceneObjects[packets[i].object], instances[i]);
+            }
+        }
+
+        if (config.instanced)
+        {
+            recordInstanceBatches(bindings, packets, firstObject, lastObject);
+            return;
+        }
+        //逐物体绘制，但没有逐物体的描述符绑定
+        for (uint32_t i = firstObject; i < lastObject; i++)
+        {
+            bindings.bindPipeline(queuePipeline(packets[i].key));
+            vkCmdDrawIndexed(commandBuffer, meshIndexCount, 1, 0, 0, i);
+        }
+    }
+
+    //只有逐物体绘制需要逐绘制的数据，实例化和无绑定模式的数据来自实例缓冲
+    bool usesPushConstants() const
+    {
+        return config.pushConstants && !config.instanced && !config.bindless;
+    }
+
+    //推送常量绘制：描述符集只在开始时绑定一次，uniformBase指向整帧共用的观察和投影矩阵，
+    //每个物体的变换和颜色直接记录在指令缓冲中，不经过环形缓冲
+    void recordPushConstantDraws(BindingCache& bindings, const RenderQueue::DrawPacket* packets, uint32_t firstObject,
+        uint32_t lastObject, uint32_t uniformBase)
+    {
+        VkCommandBuffer commandBuffer = bindings.getCommandBuffer();
+        bindings.bindDescriptorSet(pipelineLayout, 0, descriptorSet, 1, &uniformBase);
+        for (uint32_t i = firstObject; i < lastObject; i++)
+        {
+            bindings.bindPipeline(queuePipeline(packets[i].key));
+            DrawPushConstants constants;
+            writeInstanceData(sceneObjects[packets[i].object], constants);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+            vkCmdDrawIndexed(commandBuffer, meshIndexCount, 1, 0, 0, 0);
+        }
+    }
+
+    //不使用实例化时每个物体一次绘制，各自写入uniform数据并使用自己的动态偏移
+    void recordObjectDraws(BindingCache& bindings, const RenderQueue::DrawPacket* packets, uint32_t firstObject,
+        uint32_t lastObject, uint32_t uniformBase, bool writeData)
+    {
+        VkDeviceSize objectStride = uniformRing.getAlignedSize(sizeof(UniformBufferObject));
+        for (uint32_t i = firstObject; i < lastObject; i++)
+        {
+            uint32_t dynamicOffset = uniformBase + static_cast<uint32_t>(i * objectStride);
+            if (writeData)
+            {
+                writeObjectUniform(sceneObjects[packets[i].object], uniformRing.getMapped(dynamicOffset));
+            }
+
+            bindings.bindPipeline(queuePipeline(packets[i].key));
+            //使用描述符集，动态偏移指向这个物体写入环形缓冲的uniform数据
+            bindings.bindDescriptorSet(pipelineLayout, 0, descriptorSet, 1, &dynamicOffset);
+            //绘制
+            vkCmdDrawIndexed(bindings.getCommandBuffer(), meshIndexCount, 1, 0, 0, 0);
+        }
+    }
+
+    //场景pass和深度预通道：这个pass排序后的绘制包被切分成若干段，由线程池并行录制到次级指令缓冲，主指令缓冲只执行次级指令缓冲
+    void recordScene(VkCommandBuffer commandBuffer, const RenderGraph::PassContext& context, bool depthOnly)
+    {
+        FrameResources& frameResources = frames[currentFrame];
+        const RenderQueue::DrawPacket* packets = depthOnly ? prepassPackets : scenePackets;
+
+        //每个线程分到几段，段数多于线程数时各线程的负载更均匀
+        uint32_t objectCount = static_cast<uint32_t>(sceneObjects.size());
+        uint32_t taskCount = std::min(objectCount, threadPool->getWorkerCount() * 4);
+        //GPU剔除时CPU上没有逐物体的工作，一次间接绘制就够了
+        if (config.gpuCulling)
+        {
+            taskCount = std::min(objectCount, 1u);
+        }
+        secondaryCommandBuffers.resize(taskCount);
+
+        threadPool->dispatch(taskCount, [&](uint32_t taskIndex, uint32_t workerIndex) {
+            uint32_t firstObject = static_cast<uint32_t>(uint64_t(objectCount) * taskIndex / taskCount);
+            uint32_t lastObject = static_cast<uint32_t>(uint64_t(objectCount) * (taskIndex + 1) / taskCount);
+            secondaryCommandBuffers[taskIndex] = recordDrawRange(frameResources.workerPools[workerIndex], context,
+                packets, firstObject, lastObject, frameUniformBase, depthOnly);
+        });
+
+        if (taskCount > 0)
+        {
+            vkCmdExecuteCommands(commandBuffer, taskCount, secondaryCommandBuffers.data());
+        }
+    }
+
+    //录制一帧的指令，调用前这一帧的指令池已经被重置
+    void recordCommandBuffer(FrameResources& frameResources, uint32_t imageIndex, uint32_t uniformBase)
+    {
+        VkCommandBuffer commandBuffer = frameResources.commandBuffer;
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT; //每帧重新录制，只提交一次
+        beginInfo.pInheritanceInfo = nullptr;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording command buffer");
+        }
+
+        //GPU计时从这里开始
+        profiler.writeGpuBegin(commandBuffer, static_cast<uint32_t>(currentFrame));
+
+        //如果有刚上传完的数据，先取得它们的队列族所有权
+        recordUploadAcquire(commandBuffer);
+
+        //剔除、场景和回读由渲染图按声明的顺序录制，它们之间的屏障也由渲染图生成
+        frameUniformBase = uniformBase;
+        renderGraph.execute(commandBuffer, imageIndex);
+
+        profiler.writeGpuEnd(commandBuffer, static_cast<uint32_t>(currentFrame));
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record command buffer");
+        }
+    }
+#pragma endregion
+
+#pragma region 顶点缓冲
+    /*  显卡可以分配不同类型的内存作为缓冲使用。不同类型的内存所允许
+        进行的操作以及操作的效率有所不同。内存类型的选择和内存块的管理
+        都交给MemoryAllocator，这里只需要说明需要的内存属性。*/
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+        VkBuffer& buffer, Allocation& bufferAllocation)
+    {
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;//指定缓冲中数据的使用目的
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;//缓冲可以被特定的队列族所拥有，指定共享模式，这里使用独有模式
+
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+        {
+            LOG_ERROR("failed to create buffer");
+        }
+
+        //分配内存之前，先获取缓冲的内存需求
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+        //从分配器的内存块中切分一段
+        bufferAllocation = allocator.allocate(memRequirements, properties, AllocationType::Linear);
+        //将分配的内存与buffer绑定
+        vkBindBufferMemory(device, buffer, bufferAllocation.memory, bufferAllocation.offset);
+    }
+
+    void destroyBuffer(VkBuffer& buffer, Allocation& bufferAllocation)
+    {
+        vkDestroyBuffer(device, buffer, nullptr);
+        allocator.free(bufferAllocation);
+        buffer = VK_NULL_HANDLE;
+    }
+
+    void createVertexBuffer()
+    {
+        //深度预通道只读取位置，位置另外复制成一个紧密排列的顶点流放在交错的顶点之后，每个顶点读取的数据量更少
+        std::vector<uint8_t> positions;
+        VkDeviceSize bufferSize = meshVertexBytes;
+        if (config.depthPrepass)
+        {
+            positions = extractPositions();
+            meshPositionOffset = (meshVertexBytes + 15) / 16 * 16;
+            bufferSize = meshPositionOffset + positions.size();
+        }
+
+        //使用CPU可见的缓冲作为临时缓冲，使用显卡读取较快的缓冲作为真正的顶点缓冲
+        //GPU可见的缓冲，即vertexBuffer,指定了被用作内存传输操作的目的缓冲
+        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferAllocation);
+
+        //数据先写入上传管理器的暂存缓冲，拷贝在flush时和其他上传一起提交
+        uploadManager.uploadBuffer(vertexBuffer, 0, meshVertexData, meshVertexBytes,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        if (!positions.empty())
+        {
+            uploadManager.uploadBuffer(vertexBuffer, meshPositionOffset, positions.data(), positions.size(),
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        }
+    }
+
+    //从交错的顶点中取出位置，位置是Vertex和PackedVertex的第一个成员
+    std::vector<uint8_t> extractPositions() const
+    {
+        size_t positionSize = meshQuantized ? sizeof(PackedPositionVertex) : sizeof(PositionVertex);
+        size_t stride = static_cast<size_t>(meshVertexBytes / meshVertexCount);
+        const uint8_t* src = static_cast<const uint8_t*>(meshVertexData);
+
+        std::vector<uint8_t> positions(positionSize * meshVertexCount);
+        for (uint32_t i = 0; i < meshVertexCount; i++)
+        {
+            memcpy(&positions[i * positionSize], src + i * stride, positionSize);
+        }
+        return positions;
+    }
+
+
+#pragma endregion
+
+#pragma region 索引缓冲
+    void createIndexBuffer()
+    {
+        VkDeviceSize bufferSize = meshIndexBytes;
+
+        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferAllocation);
+
+        uploadManager.uploadBuffer(indexBuffer, 0, meshIndexData, bufferSize,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+
+    }
+#pragma endregion
+
+#pragma region 场景
+    //生成物体的网格：边长为1的四边形细分成cols*rows个小四边形，三角形数量不少于trianglesPerObject
+    void createMesh()
+    {
+        if (!config.meshFile.empty())
+        {
+            loadMeshFile();
+            return;
+        }
+
+        uint32_t quadCount = std::max(1u, (config.trianglesPerObject + 1) / 2);
+        uint32_t cols = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(quadCount))));
+        uint32_t rows = (quadCount + cols - 1) / cols;
+
+        vertices.clear();
+        vertices.reserve((cols + 1) * (rows + 1));
+        for (uint32_t y = 0; y <= rows; y++)
+        {
+            for (uint32_t x = 0; x <= cols; x++)
+            {
+                float u = static_cast<float>(x) / cols;
+                float v = static_cast<float>(y) / rows;
+                glm::vec3 bottom = glm::mix(quadCornerColors[0], quadCornerColors[1], u);
+                glm::vec3 top = glm::mix(quadCornerColors[3], quadCornerColors[2], u);
+                vertices.push_back({ glm::vec2(u - 0.5f, v - 0.5f), glm::mix(bottom, top, v) });
+            }
+        }
+
+        //和原来的四边形一样的环绕顺序
+        indices.clear();
+        indices.reserve(cols * rows * 6);
+        for (uint32_t y = 0; y < rows; y++)
+        {
+            for (uint32_t x = 0; x < cols; x++)
+            {
+                uint32_t a = y * (cols + 1) + x;
+                uint32_t b = a + 1;
+                uint32_t c = b + cols + 1;
+                uint32_t d = a + cols + 1;
+                indices.insert(indices.end(), { a, b, c, c, d, a });
+            }
+        }
+
+        if (config.optimizeMesh)
+        {
+            optimizeMesh();
+        }
+
+        //包围球以模型空间原点为中心，用于GPU视锥剔除
+        MeshFile::MeshRecord record = {};
+        record.vertexCount = static_cast<uint32_t>(vertices.size());
+        record.indexCount = static_cast<uint32_t>(indices.size());
+        glm::vec2 boundsMin = vertices[0].pos;
+        glm::vec2 boundsMax = vertices[0].pos;
+        meshRadius = 0.0f;
+        for (const auto& vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.pos);
+            boundsMax = glm::max(boundsMax, vertex.pos);
+            meshRadius = std::max(meshRadius, glm::length(vertex.pos));
+        }
+        record.boundsMin[0] = boundsMin.x;
+        record.boundsMin[1] = boundsMin.y;
+        record.boundsMax[0] = boundsMax.x;
+        record.boundsMax[1] = boundsMax.y;
+        record.radius = meshRadius;
+
+        meshQuantized = config.quantizeVertices;
+        if (meshQuantized)
+        {
+            meshPositionScale = positionScaleFromBounds(record);
+            packedVertices.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                packedVertices[i] = PackedVertex::pack(vertices[i], meshPositionScale);
+            }
+            meshVertexData = packedVertices.data();
+            meshVertexBytes = sizeof(packedVertices[0]) * packedVertices.size();
+        }
+        else
+        {
+            meshPositionScale = 1.0f;
+            meshVertexData = vertices.data();
+            meshVertexBytes = sizeof(vertices[0]) * vertices.size();
+        }
+        meshIndexData = indices.data();
+        meshIndexBytes = sizeof(indices[0]) * indices.size();
+        meshVertexCount = record.vertexCount;
+        meshIndexCount = record.indexCount;
+        meshIndexType = VK_INDEX_TYPE_UINT32;
+
+        if (!config.saveMeshFile.empty())
+        {
+            MeshFile::write(config.saveMeshFile,
+                meshQuantized ? MeshFile::VertexFormatSnorm16Pos2Unorm8Color4 : MeshFile::VertexFormatPos2Color3,
+                static_cast<uint32_t>(meshVertexBytes / record.vertexCount), meshVertexData, record.vertexCount,
+                sizeof(uint32_t), indices.data(), record.indexCount, { record });
+            printf("mesh: wrote %u vertices, %u indices to %s\n", record.vertexCount, record.indexCount,
+                config.saveMeshFile.c_str());
+        }
+    }
+
+    //三角形按Tipsify重排，再按簇排序减少过度绘制，最后按第一次引用的顺序重排顶点
+    void optimizeMesh()
+    {
+        const uint32_t cacheSize = 16;
+        auto before = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+
+        MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+        MeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), &vertices[0].pos.x, vertices.size(),
+            sizeof(Vertex), 2, cacheSize, 1.05f);
+        vertices.resize(MeshOptimizer::optimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex),
+            indices.data(), indices.size()));
+
+        auto after = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+        printf("mesh optimization: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+
+    //映射网格文件，所有物体使用文件中的第一个网格。顶点和索引在创建缓冲时直接从映射拷贝到暂存缓冲
+    void loadMeshFile()
+    {
+        meshFile.open(config.meshFile);
+
+        const MeshFile::Header& header = meshFile.getHeader();
+        meshQuantized = header.vertexFormat == MeshFile::VertexFormatSnorm16Pos2Unorm8Color4;
+        if (!(header.vertexFormat == MeshFile::VertexFormatPos2Color3 && header.vertexStride == sizeof(Vertex)) &&
+            !(meshQuantized && header.vertexStride == sizeof(PackedVertex)))
+        {
+            throw std::runtime_error("mesh file " + config.meshFile + " has an incompatible vertex format");
+        }
+
+        const MeshFile::MeshRecord& mesh = meshFile.getMesh(0);
+        if (mesh.vertexCount == 0 || mesh.indexCount == 0)
+        {
+            throw std::runtime_error("mesh file " + config.meshFile + " has an empty mesh");
+        }
+        //量化的位置是按包围盒归一化的，还原系数由包围盒决定，不需要单独保存
+        meshPositionScale = meshQuantized ? positionScaleFromBounds(mesh) : 1.0f;
+        meshVertexData = meshFile.getVertexData(mesh);
+        meshIndexData = meshFile.getIndexData(mesh);
+        meshVertexBytes = static_cast<VkDeviceSize>(mesh.vertexCount) * header.vertexStride;
+        meshIndexBytes = static_cast<VkDeviceSize>(mesh.indexCount) * header.indexSize;
+        meshVertexCount = mesh.vertexCount;
+        meshIndexCount = mesh.indexCount;
+        meshIndexType = header.indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        meshRadius = mesh.radius;
+    }
+
+    //SNORM16位置的还原系数：包围盒各分量的最大绝对值，使所有位置落在[-1, 1]内
+    static float positionScaleFromBounds(const MeshFile::MeshRecord& mesh)
+    {
+        float scale = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            scale = std::max({ scale, std::abs(mesh.boundsMin[i]), std::abs(mesh.boundsMax[i]) });
+        }
+        return scale > 0.0f ? scale : 1.0f;
+    }
+
+    //把物体排成正方形网格，整体缩放到原来一个物体的大小范围内，只有一个物体时和原来完全一样
+    void createScene()
+    {
+        uint32_t objectCount = std::max(1u, config.objectCount);
+        uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+        float cellSize = 2.0f / gridSize;
+
+        sceneObjects.resize(objectCount);
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            uint32_t x = i % gridSize;
+            uint32_t y = i / gridSize;
+            sceneObjects[i].position = glm::vec3(-1.0f + cellSize * (x + 0.5f), -1.0f + cellSize * (y + 0.5f), 0.0f);
+            sceneObjects[i].scale = 1.0f / gridSize;
+        }
+    }
+
+    //每帧把所有物体的绘制加入渲染队列并排序，深度是物体中心在观察空间中的深度，不按远近排序时为0。
+    //深度预通道和场景pass的绘制包除了pass和管线字段之外完全相同，排序之后两个区间中物体的顺序一致
+    void buildRenderQueue()
+    {
+        renderQueue.clear();
+        renderQueue.reserve(sceneObjects.size() * (config.depthPrepass ? 2 : 1));
+        for (uint32_t i = 0; i < static_cast<uint32_t>(sceneObjects.size()); i++)
+        {
+            const SceneObject& object = sceneObjects[i];
+            //观察空间中相机朝-z方向看，z越大越近
+            float depth = config.frontToBack ? -(cachedView * glm::vec4(object.position, 1.0f)).z : 0.0f;
+            if (config.depthPrepass)
+            {
+                renderQueue.push(RenderQueue::makeKey(QueuePassDepthPrepass, QueuePipelineDepth, object.material, depth), i);
+            }
+            renderQueue.push(RenderQueue::makeKey(QueuePassScene, QueuePipelineColor, object.material, depth), i);
+        }
+        renderQueue.sort();
+
+        size_t first = 0, last = 0;
+        renderQueue.getPassRange(QueuePassDepthPrepass, first, last);
+        prepassPackets = renderQueue.getPackets().data() + first;
+        renderQueue.getPassRange(QueuePassScene, first, last);
+        scenePackets = renderQueue.getPackets().data() + first;
+    }
+
+    glm::mat4 computeModelMatrix(const SceneObject& object) const
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), object.position);
+        model = glm::rotate(model, animationTime * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        return glm::scale(model, glm::vec3(object.scale));
+    }
+
+    //计算一个物体的uniform数据并写入映射的内存，可以在录制线程上调用
+    void writeObjectUniform(const SceneObject& object, void* dst)
+    {
+        UniformBufferObject ubo = {};
+        ubo.model = computeModelMatrix(object);
+        ubo.view = cachedView;
+        ubo.proj = cachedProj;
+
+        memcpy(dst, &ubo, sizeof(ubo));
+    }
+
+    //实例化绘制时物体的数据，dst指向映射的实例缓冲，可以在录制线程上调用
+    void writeInstanceData(const SceneObject& object, InstanceData& dst)
+    {
+        dst.model = computeModelMatrix(object);
+        dst.color = object.color;
+    }
+
+    //物体的位置、缩放和颜色只上传一次，之后每帧只更新剔除参数
+    void createGpuCulling()
+    {
+        gpuCulling.init(device, allocator, pipelineCache.getCache(), readFile(CULL_SHADER_PATH),
+            static_cast<uint32_t>(sceneObjects.size()), config.framesInFlight, drawIndirectCountEnabled);
+
+        std::vector<GpuCulling::ObjectData> objects(sceneObjects.size());
+        for (size_t i = 0; i < sceneObjects.size(); i++)
+        {
+            objects[i].positionScale = glm::vec4(sceneObjects[i].position, sceneObjects[i].scale);
+            objects[i].color = sceneObjects[i].color;
+        }
+        gpuCulling.uploadObjects(uploadManager, objects);
+
+        printf("gpu culling: %s\n", gpuCulling.usesDrawIndirectCount() ? "compacted draws with vkCmdDrawIndexedIndirectCount"
+            : "fixed-count vkCmdDrawIndexedIndirect");
+    }
+
+    //和computeModelMatrix使用相同的旋转，视锥来自这一帧的观察和投影矩阵
+    void updateCullParams()
+    {
+        GpuCulling::extractFrustumPlanes(cachedProj * cachedView, cullParams.frustumPlanes);
+        cullParams.angle = animationTime * glm::radians(90.0f);
+        cullParams.meshRadius = meshRadius;
+        cullParams.objectCount = static_cast<uint32_t>(sceneObjects.size());
+        cullParams.indexCount = meshIndexCount;
+    }
+#pragma endregion
+
+#pragma region 流式纹理
+    void createTextures()
+    {
+        if (config.textureFile.empty() && config.saveTextureFile.empty())
+        {
+            return;
+        }
+        if (!config.bindless)
+        {
+            printf("texture: bindless descriptors not supported, drawing untextured\n");
+            return;
+        }
+
+        std::string path = config.textureFile;
+        if (!config.saveTextureFile.empty())
+        {
+            saveGeneratedTexture(config.saveTextureFile);
+            if (path.empty())
+            {
+                path = config.saveTextureFile;
+            }
+        }
+
+        textureStreamer.init(device, physicalDevice, allocator, uploadManager, bindless,
+            static_cast<VkDeviceSize>(config.textureBudgetMB) * 1024 * 1024, graphicsTimeline);
+        sceneTexture = textureStreamer.load(path);
+    }
+
+    //生成一张2048x2048的棋盘格加渐变纹理，每一级都有可以分辨的细节，方便观察mip级别的切换
+    static void saveGeneratedTexture(const std::string& path)
+    {
+        const uint32_t size = 2048;
+        const uint32_t cells = 64;
+        std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                bool dark = ((x * cells / size) + (y * cells / size)) % 2 == 1;
+                uint8_t* texel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+                texel[0] = static_cast<uint8_t>(dark ? 64 : 128 + x * 127 / size);
+                texel[1] = static_cast<uint8_t>(dark ? 64 : 128 + y * 127 / size);
+                texel[2] = static_cast<uint8_t>(dark ? 64 : 255);
+                texel[3] = 255;
+            }
+        }
+
+        auto levels = TextureFile::generateMipsRgba8(pixels.data(), size, size);
+        TextureFile::write(path, VK_FORMAT_R8G8B8A8_UNORM, 4, size, size, levels);
+        printf("texture: wrote %ux%u with %zu mips to %s\n", size, size, levels.size(), path.c_str());
+    }
+
+    //按纹理在画面中的最大尺寸请求mip级别：屏幕上一个像素对应的纹素数取2的对数。
+    //所有物体共用一个纹理，离相机最近的物体决定需要的级别，它的屏幕尺寸同时作为优先级
+    void updateTextureStreaming()
+    {
+        if (sceneTexture == UINT32_MAX)
+        {
+            return;
+        }
+
+        //投影矩阵在第一帧更新uniform时才计算，之前只处理已经完成的上传
+        if (projExtent.width != 0)
+        {
+            float pixelsPerUnit = std::abs(cachedProj[1][1]) * 0.5f * projExtent.height;
+            float maxDiameter = 0.0f;
+            for (const SceneObject& object : sceneObjects)
+            {
+                float distance = std::max(glm::length(object.position - cameraEye), 0.1f);
+                maxDiameter = std::max(maxDiameter, 2.0f * meshRadius * object.scale * pixelsPerUnit / distance);
+            }
+
+            float textureSize = static_cast<float>(std::max(textureStreamer.getWidth(sceneTexture),
+                textureStreamer.getHeight(sceneTexture)));
+            uint32_t mipLevel = 0;
+            if (maxDiameter > 0.0f && textureSize > maxDiameter)
+            {
+                mipLevel = static_cast<uint32_t>(std::floor(std::log2(textureSize / maxDiameter)));
+            }
+            textureStreamer.request(sceneTexture, mipLevel, maxDiameter);
+        }
+        textureStreamer.update();
+    }
+#pragma endregion
+
+#pragma region 描述符集
+    void createDescriptorSetLayout()
+    {
+        VkDescriptorSetLayoutBinding uboLayoutBinding = {};
+        uboLayoutBinding.binding = 0; //着色器使用的描述符绑定
+        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; //描述符类型，绑定时指定偏移
+        uboLayoutBinding.descriptorCount = 1;
+        uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        uboLayoutBinding.pImmutableSamplers = nullptr;
+
+        VkDescriptorSetLayoutCreateInfo  layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &uboLayoutBinding;
+
+        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+        {
+            LOG_ERROR("failed to create descriptor set layout");
+        }
+    }
+
+    //这里无需想索引和顶点缓冲一样使用暂存缓冲，因为需要频繁更新缓冲数据
+    void createUniformBuffer()
+    {
+        //动态偏移必须是minUniformBufferOffsetAlignment的整数倍
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        //每个物体占用一个对齐后的跨度，每帧的一段至少要放下所有物体
+        VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+        VkDeviceSize objectStride = (sizeof(UniformBufferObject) + alignment - 1) / alignment * alignment;
+        VkDeviceSize frameSize = std::max(UNIFORM_RING_FRAME_SIZE, objectStride * sceneObjects.size());
+
+        //因为我们并行渲染多帧，每个并行帧在环形缓冲中使用独立的一段，写入时GPU不会读取同一段
+        uniformRing.create(device, allocator, alignment, frameSize, config.framesInFlight);
+
+        //实例数据也是每帧由CPU写入，同样使用保持映射的环形缓冲，每帧一段放下所有物体；GPU剔除时由计算着色器写入
+        if (config.bindless && !config.gpuCulling)
+        {
+            //无绑定模式下作为存储缓冲读取，每一帧的一段注册成一个句柄，段的起始偏移要满足存储缓冲的对齐要求
+            instanceRing.create(device, allocator, std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment,
+                alignof(glm::vec4)), sizeof(InstanceData) * sceneObjects.size(), config.framesInFlight,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        }
+        else if (config.instanced && !config.gpuCulling)
+        {
+            instanceRing.create(device, allocator, alignof(glm::vec4), sizeof(InstanceData) * sceneObjects.size(),
+                config.framesInFlight, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        }
+    }
+
+    //更新这一帧共用的数据，并为所有物体在环形缓冲中预留位置，返回第一个物体的偏移。
+    //每个物体的uniform数据在录制指令时由录制线程写入
+    uint32_t updateUniformBuffer(uint32_t frameIndex)
+    {
+        static auto startTime = std::chrono::high_resolution_clock::now();
+
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+        if (cameraDirty)
+        {
+            cachedView = glm::lookAt(cameraEye, cameraTarget, cameraUp);
+            cameraDirty = false;
+        }
+        //GPU剔除时绘制指令由计算着色器生成，不经过渲染队列
+        if (!config.gpuCulling)
+        {
+            buildRenderQueue();
+        }
+
+        if (projExtent.width != swapChainExtent.width || projExtent.height != swapChainExtent.height)
+        {
+            cachedProj = glm::perspective(glm::radians(45.0f), (float)swapChainExtent.width / (float)swapChainExtent.height,
+                0.1f, 10.0f);
+            cachedProj[1][1] *= -1;
+            projExtent = swapChainExtent;
+        }
+
+        animationTime = time;
+
+        //环形缓冲一直保持映射，写入时没有驱动调用
+        uniformRing.beginFrame(frameIndex);
+
+        if (config.bindless)
+        {
+            //这一帧的实例数据从所在段的开头写起，和注册句柄时的偏移一致
+            if (config.gpuCulling)
+            {
+                updateCullParams();
+            }
+            else
+            {
+                instanceRing.beginFrame(frameIndex);
+                instanceBase = instanceRing.allocate(sizeof(InstanceData) * sceneObjects.size());
+            }
+
+            FrameUniforms frame = {};
+            frame.view = cachedView;
+            frame.proj = cachedProj;
+            frame.instanceBuffer = instanceBufferHandles[frameIndex];
+            frame.texture = sceneTexture != UINT32_MAX ? textureStreamer.getHandle(sceneTexture)
+                : BindlessDescriptors::INVALID_HANDLE;
+            return uniformRing.push(&frame, sizeof(frame));
+        }
+
+        if (config.instanced || usesPushConstants())
+        {
+            //实例化绘制时uniform中只有整帧共用的观察和投影矩阵，物体的变换由录制线程写入实例缓冲，
+            //GPU剔除时由计算着色器写入；推送常量绘制时由录制线程写入指令缓冲
+            if (config.gpuCulling)
+            {
+                updateCullParams();
+            }
+            else if (config.instanced)
+            {
+                instanceRing.beginFrame(frameIndex);
+                instanceBase = instanceRing.allocate(sizeof(InstanceData) * sceneObjects.size());
+            }
+
+            UniformBufferObject ubo = {};
+            ubo.model = glm::mat4(1.0f);
+            ubo.view = cachedView;
+            ubo.proj = cachedProj;
+            return uniformRing.push(&ubo, sizeof(ubo));
+        }
+
+        VkDeviceSize objectStride = uniformRing.getAlignedSize(sizeof(UniformBufferObject));
+        return uniformRing.allocate(objectStride * sceneObjects.size());
+    }
+
+    void createDescriptorPool()
+    {
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        poolSize.descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = 1;
+
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+        {
+            LOG_ERROR("failed to create descriptor pool");
+        }
+    }
+
+    void createDescriptorSets() 
+    {
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+        {
+            LOG_ERROR("failed to allocate descriptor sets");
+        }
+
+        //描述符指向环形缓冲的开头，实际读取的位置由绑定时的动态偏移决定
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer = uniformRing.getBuffer();
+        bufferInfo.offset = 0;
+        bufferInfo.range = sizeof(UniformBufferObject);
+
+        VkWriteDescriptorSet descriptorWrite = {};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = descriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = 0;
+
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptorWrite.descriptorCount = 1;
+
+        descriptorWrite.pBufferInfo = &bufferInfo;
+        descriptorWrite.pImageInfo = nullptr;
+        descriptorWrite.pTexelBufferView = nullptr;
+
+        vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+
+        //无绑定模式下每个并行帧的实例数据注册一个句柄，之后只写入uniform中的句柄，不再更新描述符
+        if (config.bindless)
+        {
+            for (uint32_t frame = 0; frame < config.framesInFlight; frame++)
+            {
+                if (config.gpuCulling)
+                {
+                    instanceBufferHandles.push_back(bindless.addBuffer(gpuCulling.getInstanceBuffer(frame), 0, VK_WHOLE_SIZE));
+                }
+                else
+                {
+                    instanceBufferHandles.push_back(bindless.addBuffer(instanceRing.getBuffer(),
+                        instanceRing.getFrameOffset(frame), instanceRing.getFrameSize()));
+                }
+            }
+        }
+    }
+#pragma endregion
+
+#pragma region 具体绘制
+    void drawFrame()
+    {
+        //在获取图像之前处理窗口大小变化，这一帧直接按新的大小渲染
+        handlePendingResize();
+
+        FrameResources& frameResources = frames[currentFrame];
+        profiler.beginFrame(static_cast<uint32_t>(currentFrame));
+        //等到这一帧上次提交的值，不需要重置，获取图像失败提前返回时也不会留下没有触发的同步对象
+        graphicsTimeline.wait(frameResources.timelineValue);
+        presentLatency.poll(swapChain);
+        applyReloadedPipelines();
+        updateTextureStreaming();
+        //这一帧上次提交的指令已经执行完，可以读取它的GPU时间戳
+        profiler.endPhase(FrameProfiler::PhaseWait);
+        profiler.collectGpu(static_cast<uint32_t>(currentFrame));
+        
+        //从交换链获取一张图像
+        uint32_t imageIndex;
+        VkResult result = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), frameResources.imageAvailableSemaphore,
+            VK_NULL_HANDLE, &imageIndex);
+        profiler.endPhase(FrameProfiler::PhaseAcquire);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            recreateSwapChain();
+            return;
+        }
+        else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
+
+        //回收已经完成的上传批次
+        collectUploads();
+
+        uint32_t uniformBase = updateUniformBuffer(static_cast<uint32_t>(currentFrame));
+        profiler.endPhase(FrameProfiler::PhaseUpdate);
+
+        //GPU已经执行完这一帧上次提交的指令，整个重置指令池后重新录制
+        resetFrameCommandPools(frameResources);
+        recordCommandBuffer(frameResources, imageIndex, uniformBase);
+        profiler.endPhase(FrameProfiler::PhaseRecord);
+
+        //提交指令缓冲
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+        //除了交换链图像，还要等待这一帧acquire的上传批次；二进制信号量对应的值被忽略
+        std::vector<VkSemaphore> waitSemaphores = { frameResources.imageAvailableSemaphore };
+        std::vector<uint64_t> waitValues = { 0 };
+        std::vector<VkPipelineStageFlags> waitStages = {
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+        };
+        waitSemaphores.insert(waitSemaphores.end(), uploadWaitSemaphores.begin(), uploadWaitSemaphores.end());
+        waitValues.insert(waitValues.end(), uploadWaitValues.begin(), uploadWaitValues.end());
+        waitStages.insert(waitStages.end(), uploadWaitStages.begin(), uploadWaitStages.end());
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frameResources.commandBuffer; //提交刚刚为获取的交换链图像录制的指令缓冲对象。
+
+        //呈现只能等待二进制信号量，CPU和之后的提交等待时间线上这一帧的值
+        frameResources.timelineValue = graphicsTimeline.nextValue();
+        VkSemaphore signalSemaphores[] = { frameResources.renderFinishedSemaphore, graphicsTimeline.get() };
+        uint64_t signalValues[] = { 0, frameResources.timelineValue };
+        submitInfo.signalSemaphoreCount = 2;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = 2;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
+        submitInfo.pNext = &timelineInfo;
+
+        //提交指令缓冲给图形指令队列
+        uint64_t presentId = presentLatency.beginFrame(profiler.getFrameNumber(), frameResources.timelineValue);
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit draw command buffer");
+        }
+        profiler.endPhase(FrameProfiler::PhaseSubmit);
+
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &frameResources.renderFinishedSemaphore;
+
+        VkSwapchainKHR swapChains[] = { swapChain };
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+        presentInfo.pImageIndices = &imageIndex;
+
+        presentInfo.pResults = nullptr;
+        VkPresentIdKHR presentIdInfo;
+        PresentLatency::chainPresentId(presentInfo, presentIdInfo, presentId);
+
+        //请求交换链进行图像呈现操作
+        result = vkQueuePresentKHR(presentQueue, &presentInfo);
+        profiler.endPhase(FrameProfiler::PhasePresent);
+        profiler.endFrame();
+
+        //交换链已经不能用时立即重建；只是不够理想时推迟到下一帧开始，和窗口大小变化的事件合并处理
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            framebufferResized = false;
+            recreateSwapChain();
+        }
+        else if (result == VK_SUBOPTIMAL_KHR) {
+            swapChainSuboptimal = true;
+        }
+        else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to present swap chain image!");
+        }
+
+        currentFrame = (currentFrame + 1) % config.framesInFlight;
+    }
+
+    //离屏模式下的一帧：没有获取图像和呈现，不需要二进制信号量，只用时间线等待这一帧之前的使用完成
+    void drawOffscreenFrame()
+    {
+        FrameResources& frameResources = frames[currentFrame];
+        profiler.beginFrame(static_cast<uint32_t>(currentFrame));
+        graphicsTimeline.wait(frameResources.timelineValue);
+        presentLatency.poll(VK_NULL_HANDLE);
+        applyReloadedPipelines();
+        updateTextureStreaming();
+        profiler.endPhase(FrameProfiler::PhaseWait);
+        profiler.collectGpu(static_cast<uint32_t>(currentFrame));
+
+        //离屏图像和并行帧一一对应
+        uint32_t imageIndex = static_cast<uint32_t>(currentFrame);
+
+        //这张图像上一次的渲染已经完成，在覆盖之前取回，计入获取图像的阶段
+        if (config.readback)
+        {
+            collectReadback(imageIndex);
+        }
+        profiler.endPhase(FrameProfiler::PhaseAcquire);
+
+        collectUploads();
+
+        uint32_t uniformBase = updateUniformBuffer(static_cast<uint32_t>(currentFrame));
+        profiler.endPhase(FrameProfiler::PhaseUpdate);
+
+        resetFrameCommandPools(frameResources);
+        recordCommandBuffer(frameResources, imageIndex, uniformBase);
+        profiler.endPhase(FrameProfiler::PhaseRecord);
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(uploadWaitSemaphores.size());
+        submitInfo.pWaitSemaphores = uploadWaitSemaphores.data();
+        submitInfo.pWaitDstStageMask = uploadWaitStages.data();
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frameResources.commandBuffer;
+
+        frameResources.timelineValue = graphicsTimeline.nextValue();
+        VkSemaphore signalSemaphore = graphicsTimeline.get();
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &signalSemaphore;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(uploadWaitValues.size());
+        timelineInfo.pWaitSemaphoreValues = uploadWaitValues.data();
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &frameResources.timelineValue;
+        submitInfo.pNext = &timelineInfo;
+
+        presentLatency.beginFrame(profiler.getFrameNumber(), frameResources.timelineValue);
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit draw command buffer");
+        }
+        profiler.endPhase(FrameProfiler::PhaseSubmit);
+        profiler.endFrame();
+
+        if (config.readback)
+        {
+            readbackPending[imageIndex] = true;
+        }
+
+        currentFrame = (currentFrame + 1) % config.framesInFlight;
+    }
+
+    void createSyncObjects()
+    {
+        //交换链的获取和呈现只支持二进制信号量，CPU和GPU之间的同步使用图形队列的时间线
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        for (auto& frameResources : frames)
+        {
+            if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frameResources.imageAvailableSemaphore) != VK_SUCCESS
+                || vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frameResources.renderFinishedSemaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create semaphores");
+            }
+        }
+    }
+#pragma endregion
+
+#pragma region 着色器热重载
+    //glslc默认使用VULKAN_SDK下的版本，没有设置环境变量时从PATH中查找
+    std::string shaderCompilerPath() const
+    {
+        if (!config.shaderCompiler.empty())
+        {
+            return config.shaderCompiler;
+        }
+        const char* sdk = std::getenv("VULKAN_SDK");
+        return sdk ? std::string(sdk) + "/Bin/glslc" : std::string("glslc");
+    }
+
+    void createShaderWatcher()
+    {
+        shaderWatcher.addTarget("graphics pipeline", {
+            { vertexShaderSource(), vertexShaderPath() },
+            { fragmentShaderSource(), fragmentShaderPath() } },
+            [this] { reloadGraphicsPipeline(); });
+        if (config.depthPrepass)
+        {
+            shaderWatcher.addTarget("depth prepass pipeline", { { depthShaderSource(), depthShaderPath() } },
+                [this] { reloadDepthPipeline(); });
+        }
+        if (config.gpuCulling)
+        {
+            shaderWatcher.addTarget("culling pipeline", { { "./shader/cull.comp", CULL_SHADER_PATH } },
+                [this] { reloadCullPipeline(); });
+        }
+        shaderWatcher.start(shaderCompilerPath(), 250ms);
+    }
+
+    //在监视线程上调用，只读取创建管线需要的对象，不碰正在录制的指令缓冲
+    void reloadGraphicsPipeline()
+    {
+        auto vertShaderCode = readFile(vertexShaderPath());
+        auto fragShaderCode = readFile(fragmentShaderPath());
+
+        double createMs = 0.0;
+        VkPipeline pipeline;
+        {
+            std::lock_guard<std::mutex> buildLock(pipelineBuildMutex);
+            pipeline = buildGraphicsPipeline(vertShaderCode, fragShaderCode, createMs);
+        }
+        printf("shader watcher: vkCreateGraphicsPipelines took %.3f ms\n", createMs);
+
+        //上一个还没换上的管线直接被新的取代
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        if (pendingGraphicsPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, pendingGraphicsPipeline, nullptr);
+        }
+        pendingGraphicsPipeline = pipeline;
+    }
+
+    void reloadDepthPipeline()
+    {
+        auto vertShaderCode = readFile(depthShaderPath());
+
+        double createMs = 0.0;
+        VkPipeline pipeline;
+        {
+            std::lock_guard<std::mutex> buildLock(pipelineBuildMutex);
+            pipeline = buildGraphicsPipeline(vertShaderCode, {}, createMs, true);
+        }
+        printf("shader watcher: depth prepass vkCreateGraphicsPipelines took %.3f ms\n", createMs);
+
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        if (pendingDepthPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, pendingDepthPipeline, nullptr);
+        }
+        pendingDepthPipeline = pipeline;
+    }
+
+    void reloadCullPipeline()
+    {
+        VkPipeline pipeline = gpuCulling.buildPipeline(pipelineCache.getCache(), readFile(CULL_SHADER_PATH));
+
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        if (pendingCullPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, pendingCullPipeline, nullptr);
+        }
+        pendingCullPipeline = pipeline;
+    }
+
+    //每帧等待时间线之后调用，替换管线只是交换句柄，不会等待后台线程的编译
+    void applyReloadedPipelines()
+    {
+        if (!config.watchShaders)
+        {
+            return;
+        }
+
+        auto end = std::remove_if(retiredPipelines.begin(), retiredPipelines.end(), [this](const RetiredPipeline& retired) {
+            if (!graphicsTimeline.isReached(retired.timelineValue))
+            {
+                return false;
+            }
+            vkDestroyPipeline(device, retired.pipeline, nullptr);
+            return true;
+        });
+        retiredPipelines.erase(end, retiredPipelines.end());
+
+        //监视线程正在写入时不等待，下一帧再替换
+        std::unique_lock<std::mutex> lock(reloadMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return;
+        }
+        if (pendingGraphicsPipeline != VK_NULL_HANDLE)
+        {
+            retiredPipelines.push_back({ graphicsPipeline, graphicsTimeline.getPendingValue() });
+            graphicsPipeline = pendingGraphicsPipeline;
+            pendingGraphicsPipeline = VK_NULL_HANDLE;
+        }
+        if (pendingDepthPipeline != VK_NULL_HANDLE)
+        {
+            retiredPipelines.push_back({ depthPipeline, graphicsTimeline.getPendingValue() });
+            depthPipeline = pendingDepthPipeline;
+            pendingDepthPipeline = VK_NULL_HANDLE;
+        }
+        if (pendingCullPipeline != VK_NULL_HANDLE)
+        {
+            retiredPipelines.push_back({ gpuCulling.replacePipeline(pendingCullPipeline), graphicsTimeline.getPendingValue() });
+            pendingCullPipeline = VK_NULL_HANDLE;
+        }
+    }
+
+    //监视线程停止之后调用
+    void destroyReloadedPipelines()
+    {
+        for (const auto& retired : retiredPipelines)
+        {
+            vkDestroyPipeline(device, retired.pipeline, nullptr);
+        }
+        retiredPipelines.clear();
+        if (pendingGraphicsPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, pendingGraphicsPipeline, nullptr);
+            pendingGraphicsPipeline = VK_NULL_HANDLE;
+        }
+        if (pendingDepthPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, pendingDepthPipeline, nullptr);
+            pendingDepthPipeline = VK_NULL_HANDLE;
+        }
+        if (pendingCullPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, pendingCullPipeline, nullptr);
+            pendingCullPipeline = VK_NULL_HANDLE;
+        }
+    }
+#pragma endregion
+
+};
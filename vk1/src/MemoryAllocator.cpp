@@ -0,0 +1,364 @@
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+//判断前一个资源的最后一个字节和后一个资源的第一个字节是否落在同一个granularity页内
+static bool onSamePage(VkDeviceSize aEnd, VkDeviceSize bStart, VkDeviceSize pageSize)
+{
+    VkDeviceSize mask = ~(pageSize - 1);
+    return (aEnd & mask) == (bStart & mask);
+}
+
+void MemoryAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize)
+{
+    this->device = device;
+    this->preferredBlockSize = preferredBlockSize;
+
+    //内存属性只查询一次并缓存
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+    maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    blocks.clear();
+    blocks.resize(memProperties.memoryTypeCount);
+}
+
+void MemoryAllocator::destroy()
+{
+    for (uint32_t type = 0; type < blocks.size(); type++)
+    {
+        for (uint32_t i = 0; i < blocks[type].size(); i++)
+        {
+            if (blocks[type][i])
+            {
+                destroyBlock(type, i);
+            }
+        }
+    }
+    blocks.clear();
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if (typeFilter & (1 << i) &&
+            (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find suitable memory type");
+}
+
+//小堆(比如集成显卡上设备本地的小块显存)上使用更小的块，避免一个块占掉整个堆
+VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) const
+{
+    uint32_t heapIndex = memProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkDeviceSize heapSize = memProperties.memoryHeaps[heapIndex].size;
+    return std::min(preferredBlockSize, alignUp(heapSize / 8, 1024));
+}
+
+uint32_t MemoryAllocator::createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated)
+{
+    if (maxAllocationCount != 0 && deviceAllocationCount >= maxAllocationCount)
+    {
+        throw std::runtime_error("exceeded maxMemoryAllocationCount");
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    auto block = std::make_unique<Block>();
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate memory block");
+    }
+    deviceAllocationCount++;
+
+    block->size = size;
+    block->dedicated = dedicated;
+    block->ranges[0] = { size, true, AllocationType::Linear };
+    block->freeBySize.insert({ size, 0 });
+
+    //主机可见的块整块映射一次，之后的子分配直接使用映射地址
+    if (memProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped);
+    }
+
+    auto& typeBlocks = blocks[memoryTypeIndex];
+    for (uint32_t i = 0; i < typeBlocks.size(); i++)
+    {
+        if (!typeBlocks[i])
+        {
+            typeBlocks[i] = std::move(block);
+            return i;
+        }
+    }
+    typeBlocks.push_back(std::move(block));
+    return static_cast<uint32_t>(typeBlocks.size() - 1);
+}
+
+void MemoryAllocator::destroyBlock(uint32_t memoryTypeIndex, uint32_t blockIndex)
+{
+    auto& block = blocks[memoryTypeIndex][blockIndex];
+    if (block->mapped != nullptr)
+    {
+        vkUnmapMemory(device, block->memory);
+    }
+    vkFreeMemory(device, block->memory, nullptr);
+    deviceAllocationCount--;
+    block.reset();
+}
+
+void MemoryAllocator::removeFreeRange(Block& block, VkDeviceSize offset, VkDeviceSize size)
+{
+    auto range = block.freeBySize.equal_range(size);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == offset)
+        {
+            block.freeBySize.erase(it);
+            return;
+        }
+    }
+}
+
+bool MemoryAllocator::allocateFromBlock(Block& block, const VkMemoryRequirements& requirements, AllocationType type,
+    VkDeviceSize& outOffset)
+{
+    VkDeviceSize size = requirements.size;
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+    //从能放下的最小空闲区间开始找，对齐或者granularity可能让较小的区间放不下，继续往大的找
+    for (auto freeIt = block.freeBySize.lower_bound(size); freeIt != block.freeBySize.end(); ++freeIt)
+    {
+        VkDeviceSize freeOffset = freeIt->second;
+        VkDeviceSize freeSize = freeIt->first;
+        auto rangeIt = block.ranges.find(freeOffset);
+
+        VkDeviceSize offset = alignUp(freeOffset, alignment);
+
+        //和前一个已分配区间类型不同且在同一页内，需要对齐到下一页
+        if (rangeIt != block.ranges.begin())
+        {
+            auto prev = std::prev(rangeIt);
+            if (!prev->second.free && prev->second.type != type &&
+                onSamePage(prev->first + prev->second.size - 1, offset, bufferImageGranularity))
+            {
+                offset = alignUp(offset, bufferImageGranularity);
+            }
+        }
+
+        if (offset + size > freeOffset + freeSize)
+        {
+            continue;
+        }
+
+        //和后一个已分配区间类型不同且在同一页内，这个空闲区间不能用
+        auto next = std::next(rangeIt);
+        if (next != block.ranges.end() && !next->second.free && next->second.type != type &&
+            onSamePage(offset + size - 1, next->first, bufferImageGranularity))
+        {
+            continue;
+        }
+
+        //把空闲区间切成：前面对齐留下的空闲区间、分配出去的区间、后面剩余的空闲区间
+        block.freeBySize.erase(freeIt);
+        block.ranges.erase(rangeIt);
+
+        if (offset > freeOffset)
+        {
+            block.ranges[freeOffset] = { offset - freeOffset, true, AllocationType::Linear };
+            block.freeBySize.insert({ offset - freeOffset, freeOffset });
+        }
+
+        block.ranges[offset] = { size, false, type };
+
+        VkDeviceSize end = offset + size;
+        VkDeviceSize freeEnd = freeOffset + freeSize;
+        if (freeEnd > end)
+        {
+            block.ranges[end] = { freeEnd - end, true, AllocationType::Linear };
+            block.freeBySize.insert({ freeEnd - end, end });
+        }
+
+        block.allocationCount++;
+        block.usedBytes += size;
+        outOffset = offset;
+        return true;
+    }
+
+    return false;
+}
+
+Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+    AllocationType type)
+{
+    uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+    VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+
+    Allocation allocation;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    allocation.size = requirements.size;
+
+    auto& typeBlocks = blocks[memoryTypeIndex];
+
+    //大资源单独分配，避免把普通块切碎
+    if (requirements.size > blockSize / 2)
+    {
+        allocation.blockIndex = createBlock(memoryTypeIndex, requirements.size, true);
+        VkDeviceSize offset = 0;
+        allocateFromBlock(*typeBlocks[allocation.blockIndex], requirements, type, offset);
+    }
+    else
+    {
+        bool found = false;
+        for (uint32_t i = 0; i < typeBlocks.size() && !found; i++)
+        {
+            if (typeBlocks[i] && !typeBlocks[i]->dedicated &&
+                allocateFromBlock(*typeBlocks[i], requirements, type, allocation.offset))
+            {
+                allocation.blockIndex = i;
+                found = true;
+            }
+        }
+
+        //现有的块都放不下，申请一个新块
+        if (!found)
+        {
+            allocation.blockIndex = createBlock(memoryTypeIndex, blockSize, false);
+            if (!allocateFromBlock(*typeBlocks[allocation.blockIndex], requirements, type, allocation.offset))
+            {
+                throw std::runtime_error("failed to suballocate memory");
+            }
+        }
+    }
+
+    Block& block = *typeBlocks[allocation.blockIndex];
+    allocation.memory = block.memory;
+    if (block.mapped != nullptr)
+    {
+        allocation.mapped = static_cast<char*>(block.mapped) + allocation.offset;
+    }
+
+    return allocation;
+}
+
+void MemoryAllocator::free(Allocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    Block& block = *blocks[allocation.memoryTypeIndex][allocation.blockIndex];
+
+    if (block.dedicated)
+    {
+        destroyBlock(allocation.memoryTypeIndex, allocation.blockIndex);
+        allocation = Allocation();
+        return;
+    }
+
+    auto it = block.ranges.find(allocation.offset);
+    if (it == block.ranges.end() || it->second.free)
+    {
+        throw std::runtime_error("invalid free of suballocation");
+    }
+
+    block.allocationCount--;
+    block.usedBytes -= it->second.size;
+    it->second.free = true;
+
+    //和后面的空闲区间合并
+    auto next = std::next(it);
+    if (next != block.ranges.end() && next->second.free)
+    {
+        removeFreeRange(block, next->first, next->second.size);
+        it->second.size += next->second.size;
+        block.ranges.erase(next);
+    }
+
+    //和前面的空闲区间合并
+    if (it != block.ranges.begin())
+    {
+        auto prev = std::prev(it);
+        if (prev->second.free)
+        {
+            removeFreeRange(block, prev->first, prev->second.size);
+            prev->second.size += it->second.size;
+            block.ranges.erase(it);
+            it = prev;
+        }
+    }
+
+    block.freeBySize.insert({ it->second.size, it->first });
+    allocation = Allocation();
+}
+
+MemoryStats MemoryAllocator::getStats(uint32_t memoryTypeIndex) const
+{
+    MemoryStats stats;
+    for (const auto& block : blocks[memoryTypeIndex])
+    {
+        if (!block)
+        {
+            continue;
+        }
+        stats.blockCount++;
+        stats.allocationCount += block->allocationCount;
+        stats.blockBytes += block->size;
+        stats.usedBytes += block->usedBytes;
+    }
+    return stats;
+}
+
+MemoryStats MemoryAllocator::getStats() const
+{
+    MemoryStats total;
+    for (uint32_t type = 0; type < blocks.size(); type++)
+    {
+        MemoryStats stats = getStats(type);
+        total.blockCount += stats.blockCount;
+        total.allocationCount += stats.allocationCount;
+        total.blockBytes += stats.blockBytes;
+        total.usedBytes += stats.usedBytes;
+    }
+    return total;
+}
+
+void MemoryAllocator::printStats() const
+{
+    const double mib = 1024.0 * 1024.0;
+    for (uint32_t type = 0; type < blocks.size(); type++)
+    {
+        MemoryStats stats = getStats(type);
+        if (stats.blockCount == 0)
+        {
+            continue;
+        }
+        printf("memory type %u (heap %u, flags 0x%x): %u blocks, %u allocations, %.2f MiB reserved, %.2f MiB used\n",
+            type, memProperties.memoryTypes[type].heapIndex, memProperties.memoryTypes[type].propertyFlags,
+            stats.blockCount, stats.allocationCount, stats.blockBytes / mib, stats.usedBytes / mib);
+    }
+
+    MemoryStats total = getStats();
+    printf("memory total: %u vkAllocateMemory calls, %u allocations, %.2f MiB reserved, %.2f MiB used\n",
+        deviceAllocationCount, total.allocationCount, total.blockBytes / mib, total.usedBytes / mib);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+//子分配的资源种类，线性资源(缓冲、线性图像)和最优排列的图像在同一页内相邻时需要满足bufferImageGranularity
+enum class AllocationType
+{
+    Linear,
+    Optimal
+};
+
+//一次子分配的结果，资源绑定到memory的offset处
+struct Allocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t memoryTypeIndex = 0;
+    uint32_t blockIndex = 0;
+    //主机可见的内存块创建后一直保持映射，这里直接指向子分配的起始地址，否则为nullptr
+    void* mapped = nullptr;
+};
+
+//内存使用统计
+struct MemoryStats
+{
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    VkDeviceSize blockBytes = 0; //向驱动申请的总大小
+    VkDeviceSize usedBytes = 0;  //子分配实际占用的大小
+};
+
+//按内存类型管理大块VkDeviceMemory，从中切分出缓冲和图像需要的内存，
+//避免每个资源都调用一次vkAllocateMemory(数量受maxMemoryAllocationCount限制，而且很慢)。
+//每个内存块内用按偏移排序的区间表记录已分配和空闲区间，空闲区间另按大小索引做best fit，释放时和相邻空闲区间合并。
+//不是线程安全的，只在主线程上使用。
+class MemoryAllocator
+{
+public:
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = 64ull * 1024 * 1024);
+    void destroy();
+
+    //在缓存的内存属性中查找满足条件的内存类型
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+    Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, AllocationType type);
+    void free(Allocation& allocation);
+
+    MemoryStats getStats() const;
+    MemoryStats getStats(uint32_t memoryTypeIndex) const;
+    void printStats() const;
+
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memProperties; }
+
+private:
+    struct Range
+    {
+        VkDeviceSize size;
+        bool free;
+        AllocationType type;
+    };
+
+    struct Block
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        //超过块大小一半的资源单独占用一个块，释放时直接归还给驱动
+        bool dedicated = false;
+        //按偏移排序的所有区间，包括空闲区间，相邻的空闲区间总是被合并
+        std::map<VkDeviceSize, Range> ranges;
+        //空闲区间：大小 -> 偏移
+        std::multimap<VkDeviceSize, VkDeviceSize> freeBySize;
+        uint32_t allocationCount = 0;
+        VkDeviceSize usedBytes = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memProperties = {};
+    VkDeviceSize bufferImageGranularity = 1;
+    uint32_t maxAllocationCount = 0;
+    uint32_t deviceAllocationCount = 0;
+    VkDeviceSize preferredBlockSize = 0;
+
+    //按内存类型索引，空指针表示已释放可以复用的位置
+    std::vector<std::vector<std::unique_ptr<Block>>> blocks;
+
+    VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+    uint32_t createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated);
+    void destroyBlock(uint32_t memoryTypeIndex, uint32_t blockIndex);
+    bool allocateFromBlock(Block& block, const VkMemoryRequirements& requirements, AllocationType type,
+        VkDeviceSize& outOffset);
+    void removeFreeRange(Block& block, VkDeviceSize offset, VkDeviceSize size);
+};
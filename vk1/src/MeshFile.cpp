@@ -0,0 +1,244 @@
+#include "MeshFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    //顺序扫描的提示让系统加大预读，拷贝时缺页更少
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    fileHandle = handle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    mappingHandle = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    mapped = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (mapped == nullptr)
+    {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    void* address = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mapped = static_cast<const uint8_t*>(address);
+    length = static_cast<size_t>(fileStat.st_size);
+
+    //数据只会从头到尾读一遍
+    madvise(address, length, MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (mapped != nullptr)
+    {
+        UnmapViewOfFile(mapped);
+    }
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle != nullptr)
+    {
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+#else
+    if (mapped != nullptr)
+    {
+        munmap(const_cast<uint8_t*>(mapped), length);
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    mapped = nullptr;
+    length = 0;
+}
+
+void MeshFile::open(const std::string& path)
+{
+    close();
+
+    if (!file.open(path))
+    {
+        throw std::runtime_error("failed to map mesh file " + path);
+    }
+
+    auto fail = [&](const char* reason) {
+        close();
+        throw std::runtime_error("invalid mesh file " + path + ": " + reason);
+    };
+
+    const uint64_t fileSize = file.size();
+    if (fileSize < sizeof(Header))
+    {
+        fail("truncated header");
+    }
+    memcpy(&header, file.data(), sizeof(Header));
+
+    if (header.magic != MAGIC)
+    {
+        fail("bad magic");
+    }
+    if (header.version != VERSION)
+    {
+        fail("unsupported version");
+    }
+    if (header.indexSize != 2 && header.indexSize != 4)
+    {
+        fail("bad index size");
+    }
+    if (header.vertexStride == 0 || header.meshCount == 0)
+    {
+        fail("empty mesh table");
+    }
+
+    //记录表紧跟在文件头之后，两个数据段按顺序排在记录表之后。
+    //偏移先和文件大小比较再做减法，所有比较都不做加法，文件中的任意值都不会回绕
+    uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.meshCount) * sizeof(MeshRecord);
+    if (tableEnd > fileSize ||
+        header.vertexOffset % SECTION_ALIGNMENT != 0 || header.indexOffset % SECTION_ALIGNMENT != 0 ||
+        header.vertexOffset < tableEnd || header.vertexOffset > fileSize ||
+        header.vertexBytes > fileSize - header.vertexOffset ||
+        header.indexOffset < header.vertexOffset || header.indexOffset - header.vertexOffset < header.vertexBytes ||
+        header.indexOffset > fileSize || header.indexBytes > fileSize - header.indexOffset ||
+        header.vertexBytes % header.vertexStride != 0 || header.indexBytes % header.indexSize != 0)
+    {
+        fail("section out of range");
+    }
+
+    meshes = reinterpret_cast<const MeshRecord*>(file.data() + sizeof(Header));
+
+    const uint64_t vertexCount = header.vertexBytes / header.vertexStride;
+    const uint64_t indexCount = header.indexBytes / header.indexSize;
+    for (uint32_t i = 0; i < header.meshCount; i++)
+    {
+        const MeshRecord& mesh = meshes[i];
+        if (static_cast<uint64_t>(mesh.firstVertex) + mesh.vertexCount > vertexCount ||
+            static_cast<uint64_t>(mesh.firstIndex) + mesh.indexCount > indexCount ||
+            mesh.indexCount % 3 != 0)
+        {
+            fail("mesh range out of range");
+        }
+    }
+}
+
+void MeshFile::close()
+{
+    file.close();
+    header = {};
+    meshes = nullptr;
+}
+
+const void* MeshFile::getVertexData(const MeshRecord& mesh) const
+{
+    return file.data() + header.vertexOffset + static_cast<uint64_t>(mesh.firstVertex) * header.vertexStride;
+}
+
+const void* MeshFile::getIndexData(const MeshRecord& mesh) const
+{
+    return file.data() + header.indexOffset + static_cast<uint64_t>(mesh.firstIndex) * header.indexSize;
+}
+
+void MeshFile::write(const std::string& path, VertexFormat vertexFormat, uint32_t vertexStride,
+    const void* vertexData, uint32_t vertexCount, uint32_t indexSize, const void* indexData, uint32_t indexCount,
+    const std::vector<MeshRecord>& meshes)
+{
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertexFormat = vertexFormat;
+    header.vertexStride = vertexStride;
+    header.indexSize = indexSize;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.vertexBytes = static_cast<uint64_t>(vertexCount) * vertexStride;
+    header.indexBytes = static_cast<uint64_t>(indexCount) * indexSize;
+    header.vertexOffset = alignSection(sizeof(Header) + meshes.size() * sizeof(MeshRecord));
+    header.indexOffset = alignSection(header.vertexOffset + header.vertexBytes);
+
+    static const char padding[SECTION_ALIGNMENT] = {};
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            throw std::runtime_error("failed to write mesh file " + tempPath);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(meshes.data()), meshes.size() * sizeof(MeshRecord));
+        out.write(padding, header.vertexOffset - (sizeof(Header) + meshes.size() * sizeof(MeshRecord)));
+        out.write(static_cast<const char*>(vertexData), header.vertexBytes);
+        out.write(padding, header.indexOffset - (header.vertexOffset + header.vertexBytes));
+        out.write(static_cast<const char*>(indexData), header.indexBytes);
+        if (!out)
+        {
+            throw std::runtime_error("failed to write mesh file " + tempPath);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        throw std::runtime_error("failed to replace mesh file " + path);
+    }
+}
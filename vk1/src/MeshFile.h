@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//只读映射整个文件，析构或close时解除映射
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //打开失败返回false，空文件也算失败
+    bool open(const std::string& path);
+    void close();
+
+    const uint8_t* data() const { return mapped; }
+    size_t size() const { return length; }
+
+private:
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+    const uint8_t* mapped = nullptr;
+    size_t length = 0;
+};
+
+//版本化的二进制网格文件，布局为：
+//  文件头 | 网格记录表 | 顶点数据段 | 索引数据段
+//两个数据段的偏移按SECTION_ALIGNMENT对齐，加载时整个文件被映射到内存，
+//顶点和索引直接从映射拷贝到暂存缓冲，中间不经过std::vector。
+//所有数值都是小端序，和文件头一起按原样写入。
+class MeshFile
+{
+public:
+    static const uint32_t MAGIC = 0x534d4b56; //"VKMS"
+    static const uint32_t VERSION = 1;
+    static const uint32_t SECTION_ALIGNMENT = 64;
+
+    //顶点格式，加载时必须和渲染器的Vertex一致
+    enum VertexFormat : uint32_t
+    {
+        VertexFormatPos2Color3 = 1,            //vec2位置 + vec3颜色
+        VertexFormatSnorm16Pos2Unorm8Color4 = 2, //SNORM16位置(按包围盒归一化) + UNORM8颜色
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexFormat;
+        uint32_t vertexStride;
+        uint32_t indexSize;   //2或4字节
+        uint32_t meshCount;
+        uint64_t vertexOffset;
+        uint64_t vertexBytes;
+        uint64_t indexOffset;
+        uint64_t indexBytes;
+    };
+
+    //一个网格在两个数据段中的范围，索引值相对于firstVertex
+    struct MeshRecord
+    {
+        uint32_t firstVertex;
+        uint32_t vertexCount;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float boundsMin[3];
+        float boundsMax[3];
+        float radius; //以模型空间原点为中心的包围球半径
+        uint32_t reserved;
+    };
+
+    //映射并校验文件，格式不对时抛出异常。只检查各个范围都在文件内，不逐个检查索引值
+    void open(const std::string& path);
+    void close();
+
+    const Header& getHeader() const { return header; }
+    uint32_t getMeshCount() const { return header.meshCount; }
+    const MeshRecord& getMesh(uint32_t index) const { return meshes[index]; }
+
+    //指向映射内存，close之后失效
+    const void* getVertexData(const MeshRecord& mesh) const;
+    const void* getIndexData(const MeshRecord& mesh) const;
+    uint64_t getFileSize() const { return file.size(); }
+
+    //写入文件：先写临时文件再重命名，失败时抛出异常。vertexData和indexData是所有网格连续存放的数据
+    static void write(const std::string& path, VertexFormat vertexFormat, uint32_t vertexStride,
+        const void* vertexData, uint32_t vertexCount, uint32_t indexSize, const void* indexData, uint32_t indexCount,
+        const std::vector<MeshRecord>& meshes);
+
+private:
+    MappedFile file;
+    Header header = {};
+    const MeshRecord* meshes = nullptr;
+
+    static uint64_t alignSection(uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+};
@@ -0,0 +1,356 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+//FIFO缓存的模拟：顶点进入缓存时记下时间戳，之后又有cacheSize个顶点进入缓存时它被挤出。
+//时间戳从cacheSize+1开始，所有顶点一开始都不在缓存中
+static bool touchCache(std::vector<uint32_t>& cacheTime, uint32_t& timestamp, uint32_t vertex, uint32_t cacheSize)
+{
+    if (timestamp - cacheTime[vertex] > cacheSize)
+    {
+        cacheTime[vertex] = timestamp++;
+        return true;
+    }
+    return false;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const uint32_t* indices, size_t indexCount,
+    size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats = {};
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return stats;
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t timestamp = cacheSize + 1;
+    size_t misses = 0;
+    size_t uniqueVertices = 0;
+
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        uint32_t vertex = indices[i];
+        if (touchCache(cacheTime, timestamp, vertex, cacheSize))
+        {
+            misses++;
+        }
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            uniqueVertices++;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / triangleCount;
+    stats.atvr = static_cast<float>(misses) / uniqueVertices;
+    return stats;
+}
+
+//Tipsify(Sander等, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw)：
+//围绕一个扇形中心顶点输出它所有还没输出的三角形，然后在刚输出的顶点中选下一个中心，
+//优先选还在缓存里、并且它剩下的三角形处理完之前不会被挤出缓存的顶点
+void MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+    {
+        return;
+    }
+
+    //每个顶点相邻的三角形，按顶点顺序连续存放
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        adjacencyOffsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        for (size_t k = 0; k < 3; k++)
+        {
+            adjacency[fillOffsets[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    //每个顶点还没输出的三角形数量
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    deadEndStack.reserve(triangleCount * 3);
+    output.reserve(triangleCount * 3);
+
+    uint32_t timestamp = cacheSize + 1;
+    size_t cursor = 0;
+    int64_t fanning = indices[0];
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+        for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+        {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            for (size_t k = 0; k < 3; k++)
+            {
+                uint32_t vertex = indices[triangle * 3 + k];
+                output.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                liveTriangles[vertex]--;
+                touchCache(cacheTime, timestamp, vertex, cacheSize);
+            }
+        }
+
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (liveTriangles[vertex] == 0)
+            {
+                continue;
+            }
+            //每个剩下的三角形最多再让两个顶点进入缓存
+            int64_t priority = 0;
+            uint32_t age = timestamp - cacheTime[vertex];
+            if (age + 2 * liveTriangles[vertex] <= cacheSize)
+            {
+                priority = age;
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next < 0)
+        {
+            //死胡同：先找最近输出过的顶点，它们最可能还在缓存里，都没有时按顺序扫描
+            while (!deadEndStack.empty())
+            {
+                uint32_t vertex = deadEndStack.back();
+                deadEndStack.pop_back();
+                if (liveTriangles[vertex] > 0)
+                {
+                    next = vertex;
+                    break;
+                }
+            }
+            while (next < 0 && cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0)
+                {
+                    next = static_cast<int64_t>(cursor);
+                }
+                cursor++;
+            }
+        }
+        fanning = next;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+//簇的切分和排序参考了同一篇论文的线性时间版本：
+//先在三个顶点都不在缓存中的三角形处切开(Tipsify跳到了新的区域)，
+//再在每一段内部，累计的ACMR降到这一段的threshold倍以下时切开。
+//每个簇用面积加权的中心和平均法线，按dot(簇中心 - 网格中心, 簇法线)从大到小排序，朝外的簇先画
+void MeshOptimizer::optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+    size_t positionStride, uint32_t positionComponents, uint32_t cacheSize, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+    {
+        return;
+    }
+
+    auto position = [&](uint32_t vertex) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+        return std::array<float, 3>{ p[0], p[1], positionComponents > 2 ? p[2] : 0.0f };
+    };
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    auto triangleMisses = [&](size_t triangle) {
+        uint32_t misses = 0;
+        for (size_t k = 0; k < 3; k++)
+        {
+            misses += touchCache(cacheTime, timestamp, indices[triangle * 3 + k], cacheSize) ? 1 : 0;
+        }
+        return misses;
+    };
+    auto resetCache = [&]() {
+        timestamp += cacheSize + 1;
+    };
+
+    std::vector<size_t> hardBoundaries;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (triangleMisses(t) == 3)
+        {
+            hardBoundaries.push_back(t);
+        }
+    }
+    if (hardBoundaries.empty() || hardBoundaries[0] != 0)
+    {
+        hardBoundaries.insert(hardBoundaries.begin(), 0);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    std::vector<size_t> boundaries;
+    for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+    {
+        size_t start = hardBoundaries[c];
+        size_t end = hardBoundaries[c + 1];
+
+        resetCache();
+        uint32_t clusterMisses = 0;
+        for (size_t t = start; t < end; t++)
+        {
+            clusterMisses += triangleMisses(t);
+        }
+        float target = threshold * clusterMisses / static_cast<float>(end - start);
+
+        boundaries.push_back(start);
+        resetCache();
+        uint32_t runningMisses = 0;
+        uint32_t runningTriangles = 0;
+        for (size_t t = start; t < end; t++)
+        {
+            runningMisses += triangleMisses(t);
+            runningTriangles++;
+            if (runningMisses <= target * runningTriangles && t + 1 < end)
+            {
+                boundaries.push_back(t + 1);
+                resetCache();
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+        //最后一个簇通常只剩几个三角形，缓存命中率很差，把它并入前一个簇
+        if (runningTriangles > 0 && boundaries.back() != start)
+        {
+            boundaries.pop_back();
+        }
+    }
+    boundaries.push_back(triangleCount);
+
+    //网格中心取所有顶点的平均位置
+    std::array<float, 3> meshCenter = { 0.0f, 0.0f, 0.0f };
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        auto p = position(static_cast<uint32_t>(v));
+        for (size_t k = 0; k < 3; k++)
+        {
+            meshCenter[k] += p[k] / vertexCount;
+        }
+    }
+
+    size_t clusterCount = boundaries.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        std::array<float, 3> center = { 0.0f, 0.0f, 0.0f };
+        std::array<float, 3> normal = { 0.0f, 0.0f, 0.0f };
+        float totalArea = 0.0f;
+
+        for (size_t t = boundaries[c]; t < boundaries[c + 1]; t++)
+        {
+            auto p0 = position(indices[t * 3 + 0]);
+            auto p1 = position(indices[t * 3 + 1]);
+            auto p2 = position(indices[t * 3 + 2]);
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            //叉积的长度是面积的两倍，直接作为权重
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (size_t k = 0; k < 3; k++)
+            {
+                center[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * area;
+                normal[k] += n[k];
+            }
+            totalArea += area;
+        }
+
+        float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float key = 0.0f;
+        if (totalArea > 0.0f && normalLength > 0.0f)
+        {
+            for (size_t k = 0; k < 3; k++)
+            {
+                key += (center[k] / totalArea - meshCenter[k]) * normal[k] / normalLength;
+            }
+        }
+        sortKeys[c] = key;
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        order[c] = c;
+    }
+    //排序键相同的簇(例如平面网格)保持原来的顺序
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(triangleCount * 3);
+    for (size_t c : order)
+    {
+        sorted.insert(sorted.end(), indices + boundaries[c] * 3, indices + boundaries[c + 1] * 3);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+size_t MeshOptimizer::optimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride,
+    uint32_t* indices, size_t indexCount)
+{
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t& slot = remap[indices[i]];
+        if (slot == unused)
+        {
+            slot = nextVertex++;
+        }
+        indices[i] = slot;
+    }
+
+    uint8_t* data = static_cast<uint8_t*>(vertices);
+    std::vector<uint8_t> original(data, data + vertexCount * vertexStride);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        if (remap[v] != unused)
+        {
+            memcpy(data + remap[v] * vertexStride, original.data() + v * vertexStride, vertexStride);
+        }
+    }
+    return nextVertex;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//上传前对网格做的重排，都是原地修改三角形列表的索引缓冲：
+//  optimizeVertexCache  用Tipsify算法重排三角形，提高变换后顶点缓存的命中率
+//  optimizeOverdraw     把上一步的结果切成簇，按朝外的程度排序，先画更可能遮挡别人的簇，减少过度绘制
+//  optimizeVertexFetch  按第一次被引用的顺序重排顶点，顶点读取更连续，并去掉没有被引用的顶点
+//三个步骤按这个顺序调用，后面的步骤不会破坏前面的结果。
+class MeshOptimizer
+{
+public:
+    //按FIFO顶点缓存模拟的统计。
+    //acmr是平均每个三角形的缓存未命中次数(0.5到3)，atvr是平均每个顶点被变换的次数(最好为1)
+    struct VertexCacheStats
+    {
+        float acmr;
+        float atvr;
+    };
+
+    static VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+        uint32_t cacheSize);
+
+    static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+
+    //positions指向第一个顶点的位置，positionStride是相邻两个顶点的字节间隔，positionComponents为2时z视为0。
+    //簇的ACMR不超过整体的threshold倍时切分，threshold越大簇越小，排序更自由但缓存命中率下降得越多
+    static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+        size_t positionStride, uint32_t positionComponents, uint32_t cacheSize, float threshold);
+
+    //原地重排vertices中的顶点并改写索引，返回被引用的顶点数量，之后的顶点可以丢弃
+    static size_t optimizeVertexFetch(void* vertices, size_t vertexCount, size_t vertexStride,
+        uint32_t* indices, size_t indexCount);
+};
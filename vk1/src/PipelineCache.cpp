@@ -0,0 +1,151 @@
+#include "PipelineCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+static const uint32_t PIPELINE_CACHE_MAGIC = 0x43504b56; //"VKPC"
+
+void PipelineCache::create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path)
+{
+    this->device = device;
+    this->path = path;
+    warm = false;
+
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    std::string data;
+    if (!path.empty())
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (file.is_open())
+        {
+            FileHeader header = {};
+            std::string body((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (body.size() >= sizeof(header))
+            {
+                memcpy(&header, body.data(), sizeof(header));
+                data = body.substr(sizeof(header));
+            }
+
+            if (isCompatible(header, data))
+            {
+                warm = true;
+            }
+            else
+            {
+                //驱动或者设备变了，旧的缓存不能用
+                printf("pipeline cache: discarding incompatible cache file %s\n", path.c_str());
+                data.clear();
+            }
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline cache");
+    }
+}
+
+//除了自己的文件头，还要检查驱动数据开头的VkPipelineCacheHeaderVersionOne，
+//它的布局是headerSize、headerVersion、vendorID、deviceID各4字节，然后是pipelineCacheUUID
+bool PipelineCache::isCompatible(const FileHeader& header, const std::string& data) const
+{
+    if (header.magic != PIPELINE_CACHE_MAGIC ||
+        header.vendorID != properties.vendorID ||
+        header.deviceID != properties.deviceID ||
+        header.driverVersion != properties.driverVersion ||
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+        header.dataSize != data.size())
+    {
+        return false;
+    }
+
+    const size_t driverHeaderSize = 16 + VK_UUID_SIZE;
+    if (data.size() < driverHeaderSize)
+    {
+        return false;
+    }
+
+    uint32_t fields[4];
+    memcpy(fields, data.data(), sizeof(fields));
+    return fields[0] >= driverHeaderSize &&
+        fields[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        fields[2] == properties.vendorID &&
+        fields[3] == properties.deviceID &&
+        memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::save()
+{
+    if (cache == VK_NULL_HANDLE || path.empty())
+    {
+        return;
+    }
+
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+    {
+        return;
+    }
+
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(device, cache, &dataSize, data.data()) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    FileHeader header = {};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = dataSize;
+
+    //先完整写入临时文件，再重命名覆盖旧文件
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            printf("pipeline cache: failed to write %s\n", tempPath.c_str());
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), dataSize);
+        if (!file)
+        {
+            printf("pipeline cache: failed to write %s\n", tempPath.c_str());
+            return;
+        }
+    }
+
+    //std::filesystem::rename会直接替换已存在的目标文件(Windows上是MoveFileEx加REPLACE_EXISTING)，
+    //读取的一方只会看到完整的旧文件或者完整的新文件
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        printf("pipeline cache: failed to replace %s: %s\n", path.c_str(), error.message().c_str());
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+void PipelineCache::destroy()
+{
+    if (cache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(device, cache, nullptr);
+        cache = VK_NULL_HANDLE;
+    }
+}
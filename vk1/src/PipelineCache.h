@@ -0,0 +1,40 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+//保存在磁盘上的VkPipelineCache。
+//启动时读取缓存文件，文件头中记录的厂商、设备、驱动版本和pipelineCacheUUID必须和当前设备一致，
+//否则丢弃旧数据从空缓存开始。退出时先写入临时文件再重命名覆盖，写到一半退出也不会留下损坏的缓存文件。
+class PipelineCache
+{
+public:
+    //path为空时不读写文件，只创建一个内存中的缓存
+    void create(VkPhysicalDevice physicalDevice, VkDevice device, const std::string& path);
+    void save();
+    void destroy();
+
+    VkPipelineCache getCache() const { return cache; }
+    //是否从磁盘读取到了有效的缓存数据
+    bool isWarm() const { return warm; }
+
+private:
+    //写在驱动返回的缓存数据前面的文件头，驱动数据自己的头里没有驱动版本，这里单独记录
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties properties = {};
+    std::string path;
+    bool warm = false;
+
+    bool isCompatible(const FileHeader& header, const std::string& data) const;
+};
@@ -0,0 +1,121 @@
+#include "PresentLatency.h"
+
+#include <cstring>
+
+bool PresentLatency::isSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_1)
+    {
+        return false;
+    }
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+    for (const char* required : requiredExtensions())
+    {
+        bool found = false;
+        for (const auto& extension : extensions)
+        {
+            if (strcmp(extension.extensionName, required) == 0)
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+
+    Features features = requiredFeatures();
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &features.presentWait;
+    features.presentWait.pNext = &features.presentId;
+    features.presentId.presentId = VK_FALSE;
+    features.presentWait.presentWait = VK_FALSE;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    return features.presentId.presentId && features.presentWait.presentWait;
+}
+
+std::vector<const char*> PresentLatency::requiredExtensions()
+{
+    return { VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME };
+}
+
+PresentLatency::Features PresentLatency::requiredFeatures()
+{
+    Features features = {};
+    features.presentId.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    features.presentId.presentId = VK_TRUE;
+    features.presentWait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    features.presentWait.presentWait = VK_TRUE;
+    return features;
+}
+
+void PresentLatency::init(VkDevice device, bool usePresentWait, FrameProfiler& profiler, TimelineSemaphore& graphicsTimeline)
+{
+    this->device = device;
+    this->profiler = &profiler;
+    this->graphicsTimeline = &graphicsTimeline;
+    waitForPresent = usePresentWait
+        ? reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"))
+        : nullptr;
+    nextPresentId = 1;
+    pending.clear();
+}
+
+uint64_t PresentLatency::beginFrame(uint64_t frame, uint64_t timelineValue)
+{
+    uint64_t presentId = waitForPresent != nullptr ? nextPresentId++ : 0;
+    pending.push_back({ frame, presentId, timelineValue, Clock::now() });
+    return presentId;
+}
+
+void PresentLatency::chainPresentId(VkPresentInfoKHR& presentInfo, VkPresentIdKHR& presentIdInfo, const uint64_t& presentId)
+{
+    if (presentId == 0)
+    {
+        return;
+    }
+
+    presentIdInfo = {};
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.pNext = presentInfo.pNext;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
+    presentInfo.pNext = &presentIdInfo;
+}
+
+void PresentLatency::poll(VkSwapchainKHR swapChain)
+{
+    //按提交顺序完成，遇到第一个没有完成的就停止
+    while (!pending.empty())
+    {
+        const Pending& front = pending.front();
+        VkResult result = waitForPresent != nullptr && front.presentId != 0
+            ? waitForPresent(device, swapChain, front.presentId, 0)
+            : (graphicsTimeline->isReached(front.timelineValue) ? VK_SUCCESS : VK_NOT_READY);
+        if (result == VK_TIMEOUT || result == VK_NOT_READY)
+        {
+            break;
+        }
+        //交换链过期等错误时这一帧不会再有结果
+        if (result == VK_SUCCESS)
+        {
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - front.submitTime).count();
+            profiler->addLatency(front.frame, ms);
+        }
+        pending.pop_front();
+    }
+}
+
+void PresentLatency::reset()
+{
+    pending.clear();
+}
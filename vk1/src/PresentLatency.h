@@ -0,0 +1,63 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "FrameProfiler.h"
+#include "TimelineSemaphore.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+//测量从CPU提交一帧到这一帧被呈现的延迟。
+//设备支持VK_KHR_present_id和VK_KHR_present_wait时，每次呈现带上递增的id，
+//之后用超时为0的vkWaitForPresentKHR查询是否已经呈现；否则退回到比较图形队列时间线上这一帧的值，测到的是提交到GPU执行完的时间。
+//查询在每帧开始时进行，测到的值比实际延迟最多多一个查询间隔。结果按帧号记录到FrameProfiler中。
+class PresentLatency
+{
+public:
+    //创建逻辑设备时链接到VkPhysicalDeviceFeatures2的pNext
+    struct Features
+    {
+        VkPhysicalDevicePresentIdFeaturesKHR presentId;
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWait;
+    };
+
+    //设备是否支持两个扩展和对应的特性，需要设备版本至少为1.1
+    static bool isSupported(VkPhysicalDevice physicalDevice);
+    static std::vector<const char*> requiredExtensions();
+    //返回值中两个结构的pNext都为空，调用者把它们链接到自己的链上
+    static Features requiredFeatures();
+
+    //usePresentWait为false时使用图形队列的时间线
+    void init(VkDevice device, bool usePresentWait, FrameProfiler& profiler, TimelineSemaphore& graphicsTimeline);
+    bool usesPresentWait() const { return waitForPresent != nullptr; }
+
+    //在vkQueueSubmit之前调用，返回这次呈现的id(不使用呈现等待时为0)，timelineValue是这次提交触发的时间线值
+    uint64_t beginFrame(uint64_t frame, uint64_t timelineValue);
+    //把id链接到呈现信息上，id为0时什么都不做
+    static void chainPresentId(VkPresentInfoKHR& presentInfo, VkPresentIdKHR& presentIdInfo, const uint64_t& presentId);
+
+    //查询已经完成的帧，每帧开始时调用
+    void poll(VkSwapchainKHR swapChain);
+    //交换链重建后旧交换链上的呈现不再能查询，直接丢弃
+    void reset();
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct Pending
+    {
+        uint64_t frame;
+        uint64_t presentId;
+        uint64_t timelineValue;
+        Clock::time_point submitTime;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    FrameProfiler* profiler = nullptr;
+    TimelineSemaphore* graphicsTimeline = nullptr;
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+    uint64_t nextPresentId = 1;
+    std::deque<Pending> pending;
+};
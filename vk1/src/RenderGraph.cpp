@@ -0,0 +1,929 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+static const VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+    | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT
+    | VK_ACCESS_MEMORY_WRITE_BIT;
+
+static const VkPipelineStageFlags DEPTH_STAGES = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+    | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+void RenderGraph::init(VkDevice device, MemoryAllocator& allocator)
+{
+    this->device = device;
+    this->allocator = &allocator;
+}
+
+void RenderGraph::reset()
+{
+    for (auto& pass : passes)
+    {
+        for (VkFramebuffer framebuffer : pass.framebuffers)
+        {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        if (pass.renderPass != VK_NULL_HANDLE)
+        {
+            vkDestroyRenderPass(device, pass.renderPass, nullptr);
+        }
+    }
+    for (auto& resource : resources)
+    {
+        if (resource.imported)
+        {
+            continue;
+        }
+        for (VkImageView view : resource.views)
+        {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        for (VkImage image : resource.images)
+        {
+            vkDestroyImage(device, image, nullptr);
+        }
+    }
+    for (auto& slot : slots)
+    {
+        allocator->free(slot.allocation);
+    }
+
+    resources.clear();
+    passes.clear();
+    slots.clear();
+    finalBarriers = BarrierBatch();
+    stats = Stats();
+    compiled = false;
+}
+
+RenderGraph::ResourceHandle RenderGraph::importImage(const std::string& name, VkFormat format, VkExtent2D extent,
+    VkImageAspectFlags aspect, const std::vector<VkImage>& images, const std::vector<VkImageView>& views,
+    VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags finalStage, VkAccessFlags finalAccess)
+{
+    Resource resource;
+    resource.name = name;
+    resource.image = true;
+    resource.imported = true;
+    resource.format = format;
+    resource.extent = extent;
+    resource.aspect = aspect;
+    resource.images = images;
+    resource.views = views;
+    resource.initialLayout = initialLayout;
+    resource.finalLayout = finalLayout;
+    resource.finalStage = finalStage;
+    resource.finalAccess = finalAccess;
+    resources.push_back(resource);
+    return static_cast<ResourceHandle>(resources.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::importBuffer(const std::string& name, VkPipelineStageFlags finalStage,
+    VkAccessFlags finalAccess)
+{
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.finalStage = finalStage;
+    resource.finalAccess = finalAccess;
+    resources.push_back(resource);
+    return static_cast<ResourceHandle>(resources.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::createImage(const std::string& name, VkFormat format, VkExtent2D extent,
+    VkImageAspectFlags aspect)
+{
+    Resource resource;
+    resource.name = name;
+    resource.image = true;
+    resource.format = format;
+    resource.extent = extent;
+    resource.aspect = aspect;
+    resources.push_back(resource);
+    return static_cast<ResourceHandle>(resources.size() - 1);
+}
+
+void RenderGraph::markOutput(ResourceHandle resource)
+{
+    resources[resource].output = true;
+}
+
+RenderGraph::PassHandle RenderGraph::addPass(const std::string& name, PassType type, ExecuteFunction execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.type = type;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+    return static_cast<PassHandle>(passes.size() - 1);
+}
+
+void RenderGraph::setSideEffect(PassHandle pass)
+{
+    passes[pass].sideEffect = true;
+}
+
+void RenderGraph::setContents(PassHandle pass, VkSubpassContents contents)
+{
+    passes[pass].contents = contents;
+}
+
+void RenderGraph::addAccess(PassHandle pass, const Access& access)
+{
+    if (access.attachment && passes[pass].type != PassType::Graphics)
+    {
+        throw std::runtime_error("render graph: attachment used outside a graphics pass " + passes[pass].name);
+    }
+    for (const auto& existing : passes[pass].accesses)
+    {
+        if (existing.resource == access.resource)
+        {
+            throw std::runtime_error("render graph: " + resources[access.resource].name
+                + " declared twice in pass " + passes[pass].name);
+        }
+    }
+    passes[pass].accesses.push_back(access);
+}
+
+void RenderGraph::writeColor(PassHandle pass, ResourceHandle image, VkAttachmentLoadOp loadOp, VkClearColorValue clear)
+{
+    Access access = {};
+    access.resource = image;
+    access.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    access.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    access.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+    {
+        access.access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+    }
+    access.write = true;
+    access.attachment = true;
+    access.loadOp = loadOp;
+    access.clear.color = clear;
+    addAccess(pass, access);
+}
+
+void RenderGraph::writeDepth(PassHandle pass, ResourceHandle image, VkAttachmentLoadOp loadOp,
+    VkClearDepthStencilValue clear)
+{
+    for (const auto& existing : passes[pass].accesses)
+    {
+        if (existing.attachment && existing.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+        {
+            throw std::runtime_error("render graph: more than one depth attachment in pass " + passes[pass].name);
+        }
+    }
+
+    Access access = {};
+    access.resource = image;
+    access.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    access.stage = DEPTH_STAGES;
+    access.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    access.write = true;
+    access.attachment = true;
+    access.loadOp = loadOp;
+    access.clear.depthStencil = clear;
+    addAccess(pass, access);
+}
+
+void RenderGraph::readBuffer(PassHandle pass, ResourceHandle buffer, VkPipelineStageFlags stage, VkAccessFlags access)
+{
+    addAccess(pass, { buffer, VK_IMAGE_LAYOUT_UNDEFINED, stage, access, false, false, VK_ATTACHMENT_LOAD_OP_LOAD, {} });
+}
+
+void RenderGraph::writeBuffer(PassHandle pass, ResourceHandle buffer, VkPipelineStageFlags stage, VkAccessFlags access)
+{
+    addAccess(pass, { buffer, VK_IMAGE_LAYOUT_UNDEFINED, stage, access, true, false, VK_ATTACHMENT_LOAD_OP_LOAD, {} });
+}
+
+void RenderGraph::readImage(PassHandle pass, ResourceHandle image, VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access)
+{
+    addAccess(pass, { image, layout, stage, access, false, false, VK_ATTACHMENT_LOAD_OP_LOAD, {} });
+}
+
+void RenderGraph::writeImage(PassHandle pass, ResourceHandle image, VkImageLayout layout, VkPipelineStageFlags stage,
+    VkAccessFlags access)
+{
+    addAccess(pass, { image, layout, stage, access, true, false, VK_ATTACHMENT_LOAD_OP_LOAD, {} });
+}
+
+void RenderGraph::compile()
+{
+    if (compiled)
+    {
+        throw std::runtime_error("render graph: compile called twice without reset");
+    }
+
+    cullPasses();
+    allocateTransients();
+    buildSynchronization();
+    for (auto& pass : passes)
+    {
+        if (pass.renderPass != VK_NULL_HANDLE)
+        {
+            createFramebuffers(pass);
+        }
+    }
+    compiled = true;
+}
+
+//从输出资源往前找：写入了需要的资源的pass被保留，它读取的资源也变成需要的。
+//附着不保留内容的写入覆盖了整个图像，在它之前对这个图像的写入就不再需要
+void RenderGraph::cullPasses()
+{
+    std::vector<bool> needed(resources.size());
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        needed[i] = resources[i].output;
+    }
+
+    stats.passCount = static_cast<uint32_t>(passes.size());
+    for (size_t p = passes.size(); p-- > 0;)
+    {
+        Pass& pass = passes[p];
+        bool live = pass.sideEffect;
+        for (const auto& access : pass.accesses)
+        {
+            live = live || (access.write && needed[access.resource]);
+        }
+        pass.culled = !live;
+        if (!live)
+        {
+            stats.culledPasses++;
+            continue;
+        }
+
+        for (const auto& access : pass.accesses)
+        {
+            if (access.attachment && access.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD)
+            {
+                needed[access.resource] = false;
+            }
+        }
+        for (const auto& access : pass.accesses)
+        {
+            if (!access.attachment || access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+            {
+                needed[access.resource] = true;
+            }
+        }
+    }
+}
+
+VkImageUsageFlags RenderGraph::usageForLayout(VkImageLayout layout)
+{
+    switch (layout)
+    {
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+        return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+        return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+        return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        return VK_IMAGE_USAGE_SAMPLED_BIT;
+    case VK_IMAGE_LAYOUT_GENERAL:
+        return VK_IMAGE_USAGE_STORAGE_BIT;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+        return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    default:
+        return 0;
+    }
+}
+
+bool RenderGraph::isWriteAccess(VkAccessFlags access)
+{
+    return (access & WRITE_ACCESS_MASK) != 0;
+}
+
+//每个临时图像的生存期是第一次到最后一次使用它的pass，按大小从大到小放进生存期不重叠、内存类型兼容的内存块中，
+//一块内存的大小和对齐取其中最大的图像
+void RenderGraph::allocateTransients()
+{
+    std::vector<ResourceHandle> transients;
+    for (size_t p = 0; p < passes.size(); p++)
+    {
+        if (passes[p].culled)
+        {
+            continue;
+        }
+        for (const auto& access : passes[p].accesses)
+        {
+            Resource& resource = resources[access.resource];
+            if (resource.imported)
+            {
+                continue;
+            }
+            if (resource.firstPass < 0)
+            {
+                resource.firstPass = static_cast<int>(p);
+                transients.push_back(access.resource);
+            }
+            resource.lastPass = static_cast<int>(p);
+            resource.usage |= usageForLayout(access.layout);
+        }
+    }
+
+    for (ResourceHandle handle : transients)
+    {
+        Resource& resource = resources[handle];
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { resource.extent.width, resource.extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = resource.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = resource.usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkImage image;
+        if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+        {
+            throw std::runtime_error("render graph: failed to create transient image " + resource.name);
+        }
+        resource.images.push_back(image);
+        vkGetImageMemoryRequirements(device, image, &resource.requirements);
+        stats.transientBytes += resource.requirements.size;
+    }
+    stats.transientImages = static_cast<uint32_t>(transients.size());
+
+    std::vector<ResourceHandle> order = transients;
+    std::stable_sort(order.begin(), order.end(), [this](ResourceHandle a, ResourceHandle b) {
+        return resources[a].requirements.size > resources[b].requirements.size;
+    });
+    for (ResourceHandle handle : order)
+    {
+        Resource& resource = resources[handle];
+        uint32_t slotIndex = UINT32_MAX;
+        for (uint32_t s = 0; s < slots.size() && slotIndex == UINT32_MAX; s++)
+        {
+            if ((slots[s].requirements.memoryTypeBits & resource.requirements.memoryTypeBits) == 0)
+            {
+                continue;
+            }
+            bool overlaps = false;
+            for (ResourceHandle other : slots[s].resources)
+            {
+                overlaps = overlaps || !(resource.lastPass < resources[other].firstPass
+                    || resources[other].lastPass < resource.firstPass);
+            }
+            if (!overlaps)
+            {
+                slotIndex = s;
+            }
+        }
+        if (slotIndex == UINT32_MAX)
+        {
+            slots.push_back(MemorySlot());
+            slotIndex = static_cast<uint32_t>(slots.size() - 1);
+            slots[slotIndex].requirements = resource.requirements;
+        }
+
+        MemorySlot& slot = slots[slotIndex];
+        slot.requirements.size = std::max(slot.requirements.size, resource.requirements.size);
+        slot.requirements.alignment = std::max(slot.requirements.alignment, resource.requirements.alignment);
+        slot.requirements.memoryTypeBits &= resource.requirements.memoryTypeBits;
+        slot.resources.push_back(handle);
+        resource.slot = slotIndex;
+    }
+
+    for (auto& slot : slots)
+    {
+        slot.allocation = allocator->allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            AllocationType::Optimal);
+        stats.aliasedBytes += slot.requirements.size;
+
+        //同一块内存上的图像按使用顺序排列，后一个第一次使用前要等前一个的最后一次使用完成，
+        //第一个要等上一帧中最后一个的使用完成(见buildSynchronization)
+        std::sort(slot.resources.begin(), slot.resources.end(), [this](ResourceHandle a, ResourceHandle b) {
+            return resources[a].firstPass < resources[b].firstPass;
+        });
+        for (size_t i = 0; i < slot.resources.size(); i++)
+        {
+            Resource& resource = resources[slot.resources[i]];
+            resource.aliasPrevious = i > 0 ? static_cast<int>(slot.resources[i - 1]) : -1;
+            vkBindImageMemory(device, resource.images[0], slot.allocation.memory, slot.allocation.offset);
+
+            VkImageViewCreateInfo viewInfo = {};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resource.images[0];
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = resource.format;
+            viewInfo.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+
+            VkImageView view;
+            if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+            {
+                throw std::runtime_error("render graph: failed to create transient image view " + resource.name);
+            }
+            resource.views.push_back(view);
+        }
+    }
+}
+
+int RenderGraph::findNextUse(ResourceHandle resource, int afterPass) const
+{
+    for (size_t p = afterPass + 1; p < passes.size(); p++)
+    {
+        if (passes[p].culled)
+        {
+            continue;
+        }
+        for (const auto& access : passes[p].accesses)
+        {
+            if (access.resource == resource)
+            {
+                return static_cast<int>(p);
+            }
+        }
+    }
+    return -1;
+}
+
+void RenderGraph::applyAccess(ResourceState& state, const Access& access)
+{
+    bool layoutChanged = state.layout != access.layout;
+    state.layout = access.layout;
+    state.used = true;
+    if (access.write)
+    {
+        state.writeStage = access.stage;
+        state.writeAccess = access.access & WRITE_ACCESS_MASK;
+        state.readStages = 0;
+        state.readAccess = 0;
+    }
+    else if (layoutChanged)
+    {
+        //布局转换也是一次写入，之后在其他阶段的读取要和这次读取的阶段同步
+        state.writeStage = access.stage;
+        state.writeAccess = 0;
+        state.readStages = access.stage;
+        state.readAccess = access.access;
+    }
+    else
+    {
+        state.readStages |= access.stage;
+        state.readAccess |= access.access;
+    }
+}
+
+bool RenderGraph::addBarrier(BarrierBatch& batch, ResourceHandle resource, const ResourceState& state,
+    VkImageLayout newLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, bool write, bool discard)
+{
+    const Resource& r = resources[resource];
+    bool layoutChange = r.image && state.layout != newLayout;
+
+    VkPipelineStageFlags srcStage = state.writeStage;
+    VkAccessFlags srcAccess = state.writeAccess;
+    bool hazard = false;
+    if (write)
+    {
+        //写后写和读后写
+        hazard = state.writeStage != 0 || state.readStages != 0;
+        srcStage |= state.readStages;
+    }
+    else
+    {
+        //读取的阶段或者访问方式还没有和上一次写入同步过
+        hazard = state.writeStage != 0
+            && ((dstStage & ~state.readStages) != 0 || (dstAccess & ~state.readAccess) != 0);
+    }
+    if (!hazard && !layoutChange)
+    {
+        return false;
+    }
+    if (srcStage == 0)
+    {
+        //这一帧中第一次使用，和之前提交的帧中同一阶段的使用同步
+        srcStage = dstStage;
+        srcAccess = write ? (dstAccess & WRITE_ACCESS_MASK) : 0;
+    }
+
+    batch.srcStage |= srcStage;
+    batch.dstStage |= dstStage;
+    if (r.image)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange = { r.aspect, 0, 1, 0, 1 };
+        batch.imageResources.push_back(resource);
+        batch.imageBarriers.push_back(barrier);
+    }
+    else if (srcAccess != 0)
+    {
+        batch.memoryBarrier = true;
+        batch.srcAccess |= srcAccess;
+        batch.dstAccess |= dstAccess;
+    }
+    return true;
+}
+
+void RenderGraph::buildSynchronization()
+{
+    std::vector<ResourceState> states(resources.size());
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        states[i].layout = resources[i].imported ? resources[i].initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+
+    //一块内存上第一个使用的临时图像要等上一帧中这块内存最后一个使用者完成，
+    //编译时不知道上一帧结束时的状态，按最后一个使用者在整帧中的所有访问同步。布局不需要接上，第一次使用时丢弃内容
+    for (const auto& slot : slots)
+    {
+        if (slot.resources.size() < 2)
+        {
+            continue;
+        }
+        ResourceHandle last = slot.resources.back();
+        ResourceState& first = states[slot.resources.front()];
+        for (const auto& pass : passes)
+        {
+            if (pass.culled)
+            {
+                continue;
+            }
+            for (const auto& access : pass.accesses)
+            {
+                if (access.resource == last)
+                {
+                    first.writeStage |= access.stage;
+                    first.writeAccess |= access.access & WRITE_ACCESS_MASK;
+                }
+            }
+        }
+    }
+
+    for (size_t p = 0; p < passes.size(); p++)
+    {
+        Pass& pass = passes[p];
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        //临时图像第一次使用时接着同一块内存上前一个图像的最后一次使用
+        for (const auto& access : pass.accesses)
+        {
+            const Resource& resource = resources[access.resource];
+            ResourceState& state = states[access.resource];
+            if (!state.used && !resource.imported && resource.aliasPrevious >= 0)
+            {
+                const ResourceState& previous = states[resource.aliasPrevious];
+                state.writeStage = previous.writeStage | previous.readStages;
+                state.writeAccess = previous.writeAccess;
+            }
+        }
+
+        for (const auto& access : pass.accesses)
+        {
+            if (access.attachment)
+            {
+                continue;
+            }
+            const Resource& resource = resources[access.resource];
+            ResourceState& state = states[access.resource];
+            if (state.syncedPass != static_cast<int>(p))
+            {
+                bool discard = !state.used && !resource.imported;
+                addBarrier(pass.barriers, access.resource, state, access.layout, access.stage, access.access,
+                    access.write, discard);
+            }
+            state.syncedPass = -1;
+            applyAccess(state, access);
+        }
+
+        if (pass.type == PassType::Graphics)
+        {
+            createRenderPass(pass, static_cast<int>(p), states);
+        }
+
+        if (pass.barriers.srcStage != 0)
+        {
+            stats.barrierBatches++;
+            stats.imageBarriers += static_cast<uint32_t>(pass.barriers.imageBarriers.size());
+        }
+    }
+
+    //外部资源在这一帧结束后要求的状态，已经由渲染流程的finalLayout完成的除外
+    int finalPass = static_cast<int>(passes.size());
+    for (size_t i = 0; i < resources.size(); i++)
+    {
+        const Resource& resource = resources[i];
+        const ResourceState& state = states[i];
+        if (!resource.imported || state.syncedPass == finalPass)
+        {
+            continue;
+        }
+        VkImageLayout finalLayout = resource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED ? resource.finalLayout : state.layout;
+        bool layoutChange = resource.image && finalLayout != state.layout;
+        if (resource.finalStage == 0 && !layoutChange)
+        {
+            continue;
+        }
+        VkPipelineStageFlags stage = resource.finalStage != 0 ? resource.finalStage
+            : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        addBarrier(finalBarriers, static_cast<ResourceHandle>(i), state, finalLayout, stage, resource.finalAccess,
+            false, false);
+    }
+    if (finalBarriers.srcStage != 0)
+    {
+        stats.barrierBatches++;
+        stats.imageBarriers += static_cast<uint32_t>(finalBarriers.imageBarriers.size());
+    }
+}
+
+//附着的布局转换和同步都交给渲染流程：
+//initialLayout是之前的布局(不保留内容时为UNDEFINED)，和之前使用的同步写成外部到子流程0的依赖；
+//finalLayout是下一次使用需要的布局，和下一次使用的同步写成子流程0到外部的依赖，下一次使用时不再需要屏障
+void RenderGraph::createRenderPass(Pass& pass, int passIndex, std::vector<ResourceState>& states)
+{
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference> colorRefs;
+    VkAttachmentReference depthRef = {};
+    bool hasDepth = false;
+
+    VkSubpassDependency enter = {};
+    enter.srcSubpass = VK_SUBPASS_EXTERNAL;
+    enter.dstSubpass = 0;
+    VkSubpassDependency leave = {};
+    leave.srcSubpass = 0;
+    leave.dstSubpass = VK_SUBPASS_EXTERNAL;
+
+    pass.clearValues.clear();
+    pass.extent = {};
+    int finalPass = static_cast<int>(passes.size());
+
+    for (const auto& access : pass.accesses)
+    {
+        if (!access.attachment)
+        {
+            continue;
+        }
+        const Resource& resource = resources[access.resource];
+        ResourceState& state = states[access.resource];
+
+        if (pass.extent.width == 0)
+        {
+            pass.extent = resource.extent;
+        }
+        else if (pass.extent.width != resource.extent.width || pass.extent.height != resource.extent.height)
+        {
+            throw std::runtime_error("render graph: attachment size mismatch in pass " + pass.name);
+        }
+
+        bool discard = access.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD || (!state.used && !resource.imported);
+        VkAttachmentDescription description = {};
+        description.format = resource.format;
+        description.samples = VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = access.loadOp;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+
+        if (state.syncedPass != passIndex)
+        {
+            VkPipelineStageFlags srcStage = state.writeStage | state.readStages;
+            VkAccessFlags srcAccess = state.writeAccess;
+            if (srcStage == 0)
+            {
+                //这一帧中第一次使用，和之前提交的帧中对它的写入同步，交换链图像的获取也在这个阶段等待
+                srcStage = access.stage;
+                srcAccess = access.access & WRITE_ACCESS_MASK;
+            }
+            enter.srcStageMask |= srcStage;
+            enter.srcAccessMask |= srcAccess;
+            enter.dstStageMask |= access.stage;
+            enter.dstAccessMask |= access.access;
+        }
+        state.syncedPass = -1;
+        applyAccess(state, access);
+
+        int next = findNextUse(access.resource, passIndex);
+        if (next >= 0)
+        {
+            const Access* nextAccess = nullptr;
+            for (const auto& candidate : passes[next].accesses)
+            {
+                if (candidate.resource == access.resource)
+                {
+                    nextAccess = &candidate;
+                }
+            }
+            description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            description.finalLayout = nextAccess->layout;
+            leave.srcStageMask |= access.stage;
+            leave.srcAccessMask |= access.access & WRITE_ACCESS_MASK;
+            leave.dstStageMask |= nextAccess->stage;
+            leave.dstAccessMask |= nextAccess->access;
+            state.layout = nextAccess->layout;
+            state.syncedPass = next;
+        }
+        else if (resource.imported)
+        {
+            description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            description.finalLayout = resource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED ? resource.finalLayout : access.layout;
+            if (resource.finalStage != 0)
+            {
+                leave.srcStageMask |= access.stage;
+                leave.srcAccessMask |= access.access & WRITE_ACCESS_MASK;
+                leave.dstStageMask |= resource.finalStage;
+                leave.dstAccessMask |= resource.finalAccess;
+            }
+            state.layout = description.finalLayout;
+            state.syncedPass = finalPass;
+        }
+        else
+        {
+            //之后没有人读取的临时附着不写回内存
+            description.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            description.finalLayout = access.layout;
+        }
+
+        VkAttachmentReference reference = {};
+        reference.attachment = static_cast<uint32_t>(attachments.size());
+        reference.layout = access.layout;
+        if (access.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+        {
+            depthRef = reference;
+            hasDepth = true;
+        }
+        else
+        {
+            colorRefs.push_back(reference);
+        }
+        attachments.push_back(description);
+        pass.clearValues.push_back(access.clear);
+    }
+
+    if (attachments.empty())
+    {
+        throw std::runtime_error("render graph: graphics pass without attachments " + pass.name);
+    }
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+    subpass.pColorAttachments = colorRefs.data();
+    subpass.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr;
+
+    std::vector<VkSubpassDependency> dependencies;
+    if (enter.srcStageMask != 0)
+    {
+        dependencies.push_back(enter);
+    }
+    if (leave.srcStageMask != 0)
+    {
+        dependencies.push_back(leave);
+    }
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS)
+    {
+        throw std::runtime_error("render graph: failed to create render pass " + pass.name);
+    }
+    stats.renderPasses++;
+}
+
+//外部图像有多张时每张一个帧缓冲，附着的顺序和渲染流程中一致
+void RenderGraph::createFramebuffers(Pass& pass)
+{
+    size_t variants = 1;
+    for (const auto& access : pass.accesses)
+    {
+        if (access.attachment)
+        {
+            variants = std::max(variants, resources[access.resource].views.size());
+        }
+    }
+
+    pass.framebuffers.resize(variants);
+    for (size_t v = 0; v < variants; v++)
+    {
+        std::vector<VkImageView> views;
+        for (const auto& access : pass.accesses)
+        {
+            if (access.attachment)
+            {
+                const Resource& resource = resources[access.resource];
+                views.push_back(resource.views[v % resource.views.size()]);
+            }
+        }
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = pass.renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+        framebufferInfo.pAttachments = views.data();
+        framebufferInfo.width = pass.extent.width;
+        framebufferInfo.height = pass.extent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &pass.framebuffers[v]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("render graph: failed to create framebuffer for pass " + pass.name);
+        }
+    }
+}
+
+void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch, uint32_t imageIndex)
+{
+    if (batch.srcStage == 0)
+    {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers = batch.imageBarriers;
+    for (size_t i = 0; i < imageBarriers.size(); i++)
+    {
+        const Resource& resource = resources[batch.imageResources[i]];
+        imageBarriers[i].image = resource.images[imageIndex % resource.images.size()];
+    }
+
+    VkMemoryBarrier memoryBarrier = {};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = batch.srcAccess;
+    memoryBarrier.dstAccessMask = batch.dstAccess;
+
+    vkCmdPipelineBarrier(commandBuffer, batch.srcStage, batch.dstStage, 0,
+        batch.memoryBarrier ? 1 : 0, &memoryBarrier, 0, nullptr,
+        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    for (auto& pass : passes)
+    {
+        if (pass.culled)
+        {
+            continue;
+        }
+        recordBarriers(commandBuffer, pass.barriers, imageIndex);
+
+        PassContext context;
+        context.extent = pass.extent;
+        context.imageIndex = imageIndex;
+        if (pass.type != PassType::Graphics)
+        {
+            pass.execute(commandBuffer, context);
+            continue;
+        }
+
+        context.renderPass = pass.renderPass;
+        context.framebuffer = pass.framebuffers[imageIndex % pass.framebuffers.size()];
+
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = context.renderPass;
+        renderPassInfo.framebuffer = context.framebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = pass.extent;
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+        renderPassInfo.pClearValues = pass.clearValues.data();
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, pass.contents);
+        pass.execute(commandBuffer, context);
+        vkCmdEndRenderPass(commandBuffer);
+    }
+    recordBarriers(commandBuffer, finalBarriers, imageIndex);
+}
+
+void RenderGraph::printSummary() const
+{
+    printf("render graph: %u passes (%u culled), %u render passes, %u barriers (%u image) per frame\n",
+        stats.passCount, stats.culledPasses, stats.renderPasses, stats.barrierBatches, stats.imageBarriers);
+    for (const auto& pass : passes)
+    {
+        if (pass.culled)
+        {
+            printf("render graph: culled pass %s\n", pass.name.c_str());
+        }
+    }
+    if (stats.transientImages > 0)
+    {
+        printf("render graph: %u transient images, %.1f MB, %.1f MB after aliasing\n", stats.transientImages,
+            stats.transientBytes / (1024.0 * 1024.0), stats.aliasedBytes / (1024.0 * 1024.0));
+    }
+}
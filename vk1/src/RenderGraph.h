@@ -0,0 +1,212 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//一帧的渲染图。
+//每个pass声明它读写哪些资源以及使用的阶段、访问方式和图像布局，compile根据这些声明：
+//剔除输出没有被使用的pass；为图形pass创建渲染流程和帧缓冲，附着的布局转换放在渲染流程的initialLayout/finalLayout中，
+//同步写成渲染流程的外部子流程依赖；其他pass之前需要的屏障合并成一条vkCmdPipelineBarrier；
+//临时图像由图创建，生存期(第一次到最后一次被使用的pass)不重叠的临时图像共用同一块内存。
+//pass按添加顺序执行，不重新排序。缓冲只作为逻辑资源跟踪，同步使用全局内存屏障，不需要缓冲句柄。
+//外部图像可以有多个(例如交换链的每张图像)，执行时按imageIndex选择，所有图像在一帧中的使用方式相同。
+//声明或者交换链变化后调用reset重新声明，再调用compile。不是线程安全的。
+class RenderGraph
+{
+public:
+    using ResourceHandle = uint32_t;
+    using PassHandle = uint32_t;
+
+    enum class PassType
+    {
+        Graphics, //包在一个只有一个子流程的渲染流程中执行
+        Compute,
+        Transfer,
+    };
+
+    //执行pass时传给回调的信息，图形pass在渲染流程内被调用
+    struct PassContext
+    {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent = {};
+        uint32_t imageIndex = 0;
+    };
+    using ExecuteFunction = std::function<void(VkCommandBuffer, const PassContext&)>;
+
+    struct Stats
+    {
+        uint32_t passCount = 0;
+        uint32_t culledPasses = 0;
+        uint32_t renderPasses = 0;
+        uint32_t barrierBatches = 0;     //每帧录制的vkCmdPipelineBarrier数量
+        uint32_t imageBarriers = 0;      //每帧屏障中的图像屏障数量，不包括渲染流程中的布局转换
+        uint32_t transientImages = 0;
+        VkDeviceSize transientBytes = 0; //共用内存之前的总大小
+        VkDeviceSize aliasedBytes = 0;   //实际分配的大小
+    };
+
+    void init(VkDevice device, MemoryAllocator& allocator);
+    //释放编译创建的对象并清除所有声明
+    void reset();
+    void destroy() { reset(); }
+
+    //外部图像。initialLayout是每帧开始时的布局，为UNDEFINED时内容可以丢弃；
+    //finalLayout/finalStage/finalAccess是这一帧结束后要求的状态，阶段为0表示之后的使用由信号量等方式同步
+    ResourceHandle importImage(const std::string& name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect,
+        const std::vector<VkImage>& images, const std::vector<VkImageView>& views, VkImageLayout initialLayout,
+        VkImageLayout finalLayout, VkPipelineStageFlags finalStage = 0, VkAccessFlags finalAccess = 0);
+    ResourceHandle importBuffer(const std::string& name, VkPipelineStageFlags finalStage = 0, VkAccessFlags finalAccess = 0);
+    //临时图像，只在一帧之内使用，每帧的内容都是未定义的
+    ResourceHandle createImage(const std::string& name, VkFormat format, VkExtent2D extent, VkImageAspectFlags aspect);
+    //写入输出资源的pass，以及它们依赖的pass不会被剔除
+    void markOutput(ResourceHandle resource);
+
+    PassHandle addPass(const std::string& name, PassType type, ExecuteFunction execute);
+    //没有输出也必须执行的pass
+    void setSideEffect(PassHandle pass);
+    //图形pass的指令录制在次级指令缓冲中时设置为VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+    void setContents(PassHandle pass, VkSubpassContents contents);
+
+    //图形pass的附着，按调用顺序成为附着0、1...，深度附着最多一个。loadOp为LOAD时保留之前的内容
+    void writeColor(PassHandle pass, ResourceHandle image, VkAttachmentLoadOp loadOp, VkClearColorValue clear = {});
+    void writeDepth(PassHandle pass, ResourceHandle image, VkAttachmentLoadOp loadOp,
+        VkClearDepthStencilValue clear = { 1.0f, 0 });
+    //附着之外的读写，stage/access是这个pass使用资源的方式
+    void readBuffer(PassHandle pass, ResourceHandle buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+    void writeBuffer(PassHandle pass, ResourceHandle buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+    void readImage(PassHandle pass, ResourceHandle image, VkImageLayout layout, VkPipelineStageFlags stage,
+        VkAccessFlags access);
+    //不是附着的写入不会丢弃图像之前的内容
+    void writeImage(PassHandle pass, ResourceHandle image, VkImageLayout layout, VkPipelineStageFlags stage,
+        VkAccessFlags access);
+
+    //剔除pass、计算同步、创建渲染流程、帧缓冲和临时图像，失败时抛出异常
+    void compile();
+    //在主指令缓冲中录制所有没有被剔除的pass
+    void execute(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+    VkRenderPass getRenderPass(PassHandle pass) const { return passes[pass].renderPass; }
+    bool isCulled(PassHandle pass) const { return passes[pass].culled; }
+    const Stats& getStats() const { return stats; }
+    void printSummary() const;
+
+private:
+    struct Access
+    {
+        ResourceHandle resource;
+        VkImageLayout layout;
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        bool write;
+        bool attachment;
+        VkAttachmentLoadOp loadOp;
+        VkClearValue clear;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        bool image = false;
+        bool imported = false;
+        bool output = false;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {};
+        VkImageAspectFlags aspect = 0;
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags finalStage = 0;
+        VkAccessFlags finalAccess = 0;
+
+        //临时图像的用法、生存期和共用内存的位置
+        VkImageUsageFlags usage = 0;
+        int firstPass = -1;
+        int lastPass = -1;
+        VkMemoryRequirements requirements = {};
+        uint32_t slot = UINT32_MAX;
+        int aliasPrevious = -1; //同一块内存上前一个使用它的临时图像
+    };
+
+    //执行一个pass之前录制的屏障，图像屏障的image在执行时按imageIndex填入
+    struct BarrierBatch
+    {
+        VkPipelineStageFlags srcStage = 0;
+        VkPipelineStageFlags dstStage = 0;
+        VkAccessFlags srcAccess = 0;
+        VkAccessFlags dstAccess = 0;
+        bool memoryBarrier = false;
+        std::vector<ResourceHandle> imageResources;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        PassType type;
+        ExecuteFunction execute;
+        std::vector<Access> accesses;
+        bool sideEffect = false;
+        bool culled = false;
+        VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE;
+
+        BarrierBatch barriers;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<VkClearValue> clearValues;
+        VkExtent2D extent = {};
+    };
+
+    //共用内存的临时图像
+    struct MemorySlot
+    {
+        VkMemoryRequirements requirements = {};
+        std::vector<ResourceHandle> resources;
+        Allocation allocation;
+    };
+
+    //编译时每个资源在当前pass之前的状态
+    struct ResourceState
+    {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStage = 0;
+        VkAccessFlags writeAccess = 0;
+        //上一次写入之后已经同步过的读取
+        VkPipelineStageFlags readStages = 0;
+        VkAccessFlags readAccess = 0;
+        bool used = false;
+        //之前的渲染流程已经通过finalLayout和外部依赖为这个pass完成了同步
+        int syncedPass = -1;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<MemorySlot> slots;
+    BarrierBatch finalBarriers;
+    Stats stats;
+    bool compiled = false;
+
+    void addAccess(PassHandle pass, const Access& access);
+    void cullPasses();
+    void allocateTransients();
+    void buildSynchronization();
+    void createRenderPass(Pass& pass, int passIndex, std::vector<ResourceState>& states);
+    void createFramebuffers(Pass& pass);
+    void recordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch, uint32_t imageIndex);
+
+    //从state同步到access需要的屏障，追加到batch，返回是否需要
+    bool addBarrier(BarrierBatch& batch, ResourceHandle resource, const ResourceState& state, VkImageLayout newLayout,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, bool write, bool discard);
+    int findNextUse(ResourceHandle resource, int afterPass) const;
+    static void applyAccess(ResourceState& state, const Access& access);
+    static VkImageUsageFlags usageForLayout(VkImageLayout layout);
+    static bool isWriteAccess(VkAccessFlags access);
+};
@@ -0,0 +1,174 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+uint64_t RenderQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth)
+{
+    if (pass >= (1u << PASS_BITS) || pipeline >= (1u << PIPELINE_BITS) || material >= (1u << MATERIAL_BITS))
+    {
+        throw std::runtime_error("render queue: sort key field out of range");
+    }
+
+    //NaN和负数都排在最前面
+    uint32_t depthBits = 0;
+    if (depth > 0.0f)
+    {
+        memcpy(&depthBits, &depth, sizeof(depthBits));
+    }
+    return (static_cast<uint64_t>(pass) << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS)) |
+        (static_cast<uint64_t>(pipeline) << (MATERIAL_BITS + DEPTH_BITS)) |
+        (static_cast<uint64_t>(material) << DEPTH_BITS) | depthBits;
+}
+
+void RenderQueue::sort()
+{
+    lastSortRounds = 0;
+    size_t count = packets.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    //一遍读出所有字节的直方图，之后每一轮只需要分配
+    std::vector<uint32_t> histograms(8 * 256, 0);
+    for (const auto& packet : packets)
+    {
+        uint64_t key = packet.key;
+        for (uint32_t b = 0; b < 8; b++)
+        {
+            histograms[b * 256 + ((key >> (8 * b)) & 0xff)]++;
+        }
+    }
+
+    scratch.resize(count);
+    DrawPacket* src = packets.data();
+    DrawPacket* dst = scratch.data();
+    for (uint32_t b = 0; b < 8; b++)
+    {
+        uint32_t* histogram = &histograms[b * 256];
+        uint32_t shift = 8 * b;
+        //所有键在这个字节上都相同，这一轮不改变顺序。深度相近或者只有一个pass、一个材质时大部分高位字节都会跳过
+        if (histogram[(src[0].key >> shift) & 0xff] == count)
+        {
+            continue;
+        }
+
+        //直方图变成每个桶的起始位置
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t bucketCount = histogram[i];
+            histogram[i] = offset;
+            offset += bucketCount;
+        }
+        //按原来的顺序分配到各个桶，保持稳定
+        for (size_t i = 0; i < count; i++)
+        {
+            dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+        std::swap(src, dst);
+        lastSortRounds++;
+    }
+
+    //奇数轮之后结果在scratch中
+    if (src != packets.data())
+    {
+        packets.swap(scratch);
+    }
+}
+
+void RenderQueue::getPassRange(uint32_t pass, size_t& first, size_t& last) const
+{
+    //排序之后pass在最高位，二分查找区间的两端
+    uint64_t passKey = static_cast<uint64_t>(pass) << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS);
+    auto lower = [this](uint64_t key) {
+        size_t low = 0, high = packets.size();
+        while (low < high)
+        {
+            size_t mid = (low + high) / 2;
+            if (packets[mid].key < key)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return low;
+    };
+    first = lower(passKey);
+    last = pass + 1 < (1u << PASS_BITS) ? lower(passKey + (1ull << (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS)))
+        : packets.size();
+}
+
+void BindingCache::bindPipeline(VkPipeline pipeline)
+{
+    if (pipeline == this->pipeline)
+    {
+        skipped++;
+        return;
+    }
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    this->pipeline = pipeline;
+    recorded++;
+}
+
+void BindingCache::bindDescriptorSet(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptorSet,
+    uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets)
+{
+    if (set >= MAX_SETS || dynamicOffsetCount > MAX_DYNAMIC_OFFSETS)
+    {
+        //超出跟踪范围的绑定直接录制
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &descriptorSet,
+            dynamicOffsetCount, dynamicOffsets);
+        recorded++;
+        return;
+    }
+
+    BoundSet& bound = sets[set];
+    if (bound.layout == layout && bound.set == descriptorSet && bound.dynamicOffsetCount == dynamicOffsetCount &&
+        (dynamicOffsetCount == 0 || memcmp(bound.dynamicOffsets, dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t)) == 0))
+    {
+        skipped++;
+        return;
+    }
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &descriptorSet,
+        dynamicOffsetCount, dynamicOffsets);
+    bound.layout = layout;
+    bound.set = descriptorSet;
+    bound.dynamicOffsetCount = dynamicOffsetCount;
+    if (dynamicOffsetCount > 0)
+    {
+        memcpy(bound.dynamicOffsets, dynamicOffsets, dynamicOffsetCount * sizeof(uint32_t));
+    }
+    //布局不同的集合可能使后面的集合失效，不再认为它们还绑定着
+    for (uint32_t i = set + 1; i < MAX_SETS; i++)
+    {
+        if (sets[i].layout != layout)
+        {
+            sets[i] = BoundSet();
+        }
+    }
+    recorded++;
+}
+
+void BindingCache::bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+{
+    if (binding < MAX_VERTEX_BINDINGS && vertexBuffers[binding].buffer == buffer && vertexBuffers[binding].offset == offset)
+    {
+        skipped++;
+        return;
+    }
+
+    vkCmdBindVertexBuffers(commandBuffer, binding, 1, &buffer, &offset);
+    if (binding < MAX_VERTEX_BINDINGS)
+    {
+        vertexBuffers[binding].buffer = buffer;
+        vertexBuffers[binding].offset = offset;
+    }
+    recorded++;
+}
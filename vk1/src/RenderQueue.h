@@ -0,0 +1,100 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//一帧的绘制队列。
+//每次绘制是一个绘制包，只有64位的排序键和物体的下标。排序键从高位到低位依次是pass、管线、材质和深度，
+//按键排序之后同一个pass的绘制连续存放，其中同一个管线、同一个材质的绘制排在一起，录制时状态切换最少，
+//状态相同的绘制按深度从近到远。
+//排序是按字节的LSD基数排序，先一遍统计出8个字节的直方图，所有键在某个字节上都相同时跳过这一轮，
+//键相同的绘制包保持加入的顺序。每帧清空后重新加入，不是线程安全的。
+class RenderQueue
+{
+public:
+    static const uint32_t PASS_BITS = 4;
+    static const uint32_t PIPELINE_BITS = 12;
+    static const uint32_t MATERIAL_BITS = 16;
+    static const uint32_t DEPTH_BITS = 32;
+
+    struct DrawPacket
+    {
+        uint64_t key;
+        uint32_t object;
+    };
+
+    //depth是到相机的距离，负数按0处理。非负浮点数的位模式和数值的大小顺序一致，直接作为键的低32位
+    static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth);
+    static uint32_t passOf(uint64_t key) { return static_cast<uint32_t>(key >> (PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS)); }
+    static uint32_t pipelineOf(uint64_t key)
+    {
+        return static_cast<uint32_t>(key >> (MATERIAL_BITS + DEPTH_BITS)) & ((1u << PIPELINE_BITS) - 1);
+    }
+    static uint32_t materialOf(uint64_t key) { return static_cast<uint32_t>(key >> DEPTH_BITS) & ((1u << MATERIAL_BITS) - 1); }
+    //除去深度之外的部分，相同时两个绘制使用同样的状态
+    static uint64_t stateOf(uint64_t key) { return key >> DEPTH_BITS; }
+
+    void clear() { packets.clear(); }
+    void reserve(size_t count) { packets.reserve(count); }
+    void push(uint64_t key, uint32_t object) { packets.push_back({ key, object }); }
+    void sort();
+
+    const std::vector<DrawPacket>& getPackets() const { return packets; }
+    size_t size() const { return packets.size(); }
+    //排序之后某个pass的绘制包所在的区间[first, last)
+    void getPassRange(uint32_t pass, size_t& first, size_t& last) const;
+    //上一次排序实际执行的轮数，最多8轮
+    uint32_t getLastSortRounds() const { return lastSortRounds; }
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> scratch;
+    uint32_t lastSortRounds = 0;
+};
+
+//一个指令缓冲中当前绑定的状态，和已经绑定的相同的管线、描述符集、顶点缓冲不再录制。
+//次级指令缓冲开始录制时没有继承任何绑定，每个指令缓冲使用自己的对象，不能跨指令缓冲共用
+class BindingCache
+{
+public:
+    static const uint32_t MAX_SETS = 4;
+    static const uint32_t MAX_DYNAMIC_OFFSETS = 4;
+    static const uint32_t MAX_VERTEX_BINDINGS = 4;
+
+    explicit BindingCache(VkCommandBuffer commandBuffer) : commandBuffer(commandBuffer) {}
+
+    void bindPipeline(VkPipeline pipeline);
+    //只绑定一个描述符集，动态偏移也参与比较
+    void bindDescriptorSet(VkPipelineLayout layout, uint32_t set, VkDescriptorSet descriptorSet,
+        uint32_t dynamicOffsetCount = 0, const uint32_t* dynamicOffsets = nullptr);
+    void bindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset);
+    VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+
+    //实际录制的绑定和因为重复而跳过的绑定
+    uint32_t getRecorded() const { return recorded; }
+    uint32_t getSkipped() const { return skipped; }
+
+private:
+    struct BoundSet
+    {
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        uint32_t dynamicOffsetCount = 0;
+        uint32_t dynamicOffsets[MAX_DYNAMIC_OFFSETS] = {};
+    };
+
+    struct BoundVertexBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+    };
+
+    VkCommandBuffer commandBuffer;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    BoundSet sets[MAX_SETS];
+    BoundVertexBuffer vertexBuffers[MAX_VERTEX_BINDINGS];
+    uint32_t recorded = 0;
+    uint32_t skipped = 0;
+};
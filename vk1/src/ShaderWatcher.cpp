@@ -0,0 +1,135 @@
+#include "ShaderWatcher.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+void ShaderWatcher::addTarget(const std::string& name, const std::vector<ShaderFile>& files, BuildCallback build)
+{
+    Target target;
+    target.name = name;
+    target.files = files;
+    target.build = std::move(build);
+    for (const auto& file : files)
+    {
+        target.sourceTimes.push_back(file.sourcePath.empty() ? FileTime() : modifiedTime(file.sourcePath));
+        target.spirvTimes.push_back(modifiedTime(file.spirvPath));
+    }
+    targets.push_back(std::move(target));
+}
+
+void ShaderWatcher::start(const std::string& compilerPath, std::chrono::milliseconds interval)
+{
+    this->compilerPath = compilerPath;
+    this->interval = interval;
+    stopping = false;
+    thread = std::thread(&ShaderWatcher::run, this);
+    printf("shader watcher: watching %zu pipelines every %lld ms\n", targets.size(),
+        static_cast<long long>(interval.count()));
+}
+
+void ShaderWatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+void ShaderWatcher::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wakeCondition.wait_for(lock, interval, [this] { return stopping; }))
+    {
+        //检查和构建都不需要持有锁，stop只会在两次检查之间生效
+        lock.unlock();
+        for (auto& target : targets)
+        {
+            poll(target);
+        }
+        lock.lock();
+    }
+}
+
+void ShaderWatcher::poll(Target& target)
+{
+    bool changed = false;
+    for (size_t i = 0; i < target.files.size(); i++)
+    {
+        const ShaderFile& file = target.files[i];
+        if (!file.sourcePath.empty())
+        {
+            FileTime sourceTime = modifiedTime(file.sourcePath);
+            if (sourceTime != target.sourceTimes[i])
+            {
+                target.sourceTimes[i] = sourceTime;
+                //编译失败时SPIR-V不变，继续使用旧管线
+                compile(file);
+            }
+        }
+
+        FileTime spirvTime = modifiedTime(file.spirvPath);
+        if (spirvTime != target.spirvTimes[i])
+        {
+            target.spirvTimes[i] = spirvTime;
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        //文件可能还在写入，等到下一次检查时没有再变化才构建
+        target.pending = true;
+        return;
+    }
+    if (!target.pending)
+    {
+        return;
+    }
+    target.pending = false;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    try {
+        target.build();
+        auto endTime = std::chrono::high_resolution_clock::now();
+        printf("shader watcher: rebuilt %s in %.3f ms\n", target.name.c_str(),
+            std::chrono::duration<double, std::milli>(endTime - startTime).count());
+    }
+    catch (const std::exception& e) {
+        printf("shader watcher: failed to rebuild %s: %s\n", target.name.c_str(), e.what());
+    }
+}
+
+bool ShaderWatcher::compile(const ShaderFile& file) const
+{
+    if (compilerPath.empty())
+    {
+        return false;
+    }
+
+    std::string command = "\"" + compilerPath + "\" \"" + file.sourcePath + "\" -o \"" + file.spirvPath + "\"";
+#ifdef _WIN32
+    //cmd /c会去掉整行最外层的一对引号
+    command = "\"" + command + "\"";
+#endif
+    int result = std::system(command.c_str());
+    if (result != 0)
+    {
+        printf("shader watcher: failed to compile %s (exit code %d)\n", file.sourcePath.c_str(), result);
+        return false;
+    }
+    return true;
+}
+
+ShaderWatcher::FileTime ShaderWatcher::modifiedTime(const std::string& path)
+{
+    //文件不存在或者正在被替换时返回默认值，下一次检查再比较
+    std::error_code error;
+    FileTime time = std::filesystem::last_write_time(path, error);
+    return error ? FileTime() : time;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//着色器热重载：后台线程定期检查着色器源文件和SPIR-V的修改时间。
+//源文件比上次检查时新，就调用编译器重新生成SPIR-V；SPIR-V变化并且在下一次检查时没有再变(已经写完)，
+//就在这个线程上调用目标的构建回调，由回调创建新管线并交给主线程在帧边界替换。
+//回调抛出的异常只打印出来，旧管线继续使用。
+class ShaderWatcher
+{
+public:
+    struct ShaderFile
+    {
+        std::string sourcePath; //为空则只监视SPIR-V
+        std::string spirvPath;
+    };
+
+    using BuildCallback = std::function<void()>;
+
+    ~ShaderWatcher() { stop(); }
+
+    //在start之前添加，name只用于打印
+    void addTarget(const std::string& name, const std::vector<ShaderFile>& files, BuildCallback build);
+
+    //compilerPath是glslc的路径，为空时不编译源文件
+    void start(const std::string& compilerPath, std::chrono::milliseconds interval);
+    void stop();
+
+private:
+    using FileTime = std::filesystem::file_time_type;
+
+    struct Target
+    {
+        std::string name;
+        std::vector<ShaderFile> files;
+        BuildCallback build;
+        std::vector<FileTime> sourceTimes;
+        std::vector<FileTime> spirvTimes;
+        //SPIR-V已经变化，等待下一次检查确认没有继续写入
+        bool pending = false;
+    };
+
+    std::vector<Target> targets;
+    std::string compilerPath;
+    std::chrono::milliseconds interval{ 250 };
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    bool stopping = false;
+
+    void run();
+    void poll(Target& target);
+    bool compile(const ShaderFile& file) const;
+    static FileTime modifiedTime(const std::string& path);
+};
@@ -0,0 +1,215 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+uint32_t TextureFile::formatTexelBytes(uint32_t format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+uint32_t TextureFile::fullMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+    {
+        count++;
+    }
+    return count;
+}
+
+void TextureFile::open(const std::string& path)
+{
+    close();
+
+    if (!file.open(path))
+    {
+        throw std::runtime_error("failed to map texture file " + path);
+    }
+
+    auto fail = [&](const char* reason) {
+        close();
+        throw std::runtime_error("invalid texture file " + path + ": " + reason);
+    };
+
+    const uint64_t fileSize = file.size();
+    if (fileSize < sizeof(Header))
+    {
+        fail("truncated header");
+    }
+    memcpy(&header, file.data(), sizeof(Header));
+
+    if (header.magic != MAGIC)
+    {
+        fail("bad magic");
+    }
+    if (header.version != VERSION)
+    {
+        fail("unsupported version");
+    }
+    if (formatTexelBytes(header.format) == 0 || header.texelBytes != formatTexelBytes(header.format))
+    {
+        fail("unsupported format");
+    }
+    //超出完整mip链的级别在创建图像时是非法的
+    if (header.width == 0 || header.height == 0 || header.mipCount == 0 ||
+        header.mipCount > MAX_MIP_LEVELS || header.mipCount > fullMipCount(header.width, header.height))
+    {
+        fail("bad dimensions");
+    }
+
+    uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.mipCount) * sizeof(MipLevel);
+    if (tableEnd > fileSize)
+    {
+        fail("truncated mip table");
+    }
+    mips = reinterpret_cast<const MipLevel*>(file.data() + sizeof(Header));
+
+    //每一级都是上一级的一半，向下取整但至少为1
+    for (uint32_t level = 0; level < header.mipCount; level++)
+    {
+        const MipLevel& mip = mips[level];
+        uint32_t expectedWidth = std::max(1u, header.width >> level);
+        uint32_t expectedHeight = std::max(1u, header.height >> level);
+        if (mip.width != expectedWidth || mip.height != expectedHeight ||
+            mip.bytes != static_cast<uint64_t>(mip.width) * mip.height * header.texelBytes)
+        {
+            fail("bad mip level size");
+        }
+        if (mip.offset % SECTION_ALIGNMENT != 0 || mip.offset < tableEnd || mip.offset > fileSize ||
+            mip.bytes > fileSize - mip.offset)
+        {
+            fail("mip level out of range");
+        }
+    }
+}
+
+void TextureFile::close()
+{
+    file.close();
+    header = {};
+    mips = nullptr;
+}
+
+void TextureFile::write(const std::string& path, uint32_t format, uint32_t texelBytes, uint32_t width, uint32_t height,
+    const std::vector<std::vector<uint8_t>>& levels)
+{
+    if (formatTexelBytes(format) == 0 || texelBytes != formatTexelBytes(format))
+    {
+        throw std::runtime_error("unsupported format for texture file " + path);
+    }
+    if (levels.empty() || levels.size() > MAX_MIP_LEVELS || levels.size() > fullMipCount(width, height))
+    {
+        throw std::runtime_error("bad mip count for texture file " + path);
+    }
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.format = format;
+    header.texelBytes = texelBytes;
+    header.width = width;
+    header.height = height;
+    header.mipCount = static_cast<uint32_t>(levels.size());
+
+    //数据段从最粗的一级开始排列
+    std::vector<MipLevel> table(levels.size());
+    uint64_t offset = alignSection(sizeof(Header) + table.size() * sizeof(MipLevel));
+    for (size_t i = levels.size(); i-- > 0;)
+    {
+        table[i].width = std::max(1u, width >> i);
+        table[i].height = std::max(1u, height >> i);
+        table[i].bytes = levels[i].size();
+        table[i].offset = offset;
+        if (table[i].bytes != static_cast<uint64_t>(table[i].width) * table[i].height * texelBytes)
+        {
+            throw std::runtime_error("bad mip level size for texture file " + path);
+        }
+        offset = alignSection(offset + table[i].bytes);
+    }
+
+    static const char padding[SECTION_ALIGNMENT] = {};
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            throw std::runtime_error("failed to write texture file " + tempPath);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(MipLevel));
+
+        uint64_t position = sizeof(Header) + table.size() * sizeof(MipLevel);
+        for (size_t i = levels.size(); i-- > 0;)
+        {
+            out.write(padding, table[i].offset - position);
+            out.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+            position = table[i].offset + table[i].bytes;
+        }
+        if (!out)
+        {
+            throw std::runtime_error("failed to write texture file " + tempPath);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        throw std::runtime_error("failed to replace texture file " + path);
+    }
+}
+
+std::vector<std::vector<uint8_t>> TextureFile::generateMipsRgba8(const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    std::vector<std::vector<uint8_t>> levels;
+    levels.emplace_back(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+    while ((width > 1 || height > 1) && levels.size() < MAX_MIP_LEVELS)
+    {
+        uint32_t nextWidth = std::max(1u, width / 2);
+        uint32_t nextHeight = std::max(1u, height / 2);
+        const std::vector<uint8_t>& src = levels.back();
+        std::vector<uint8_t> dst(static_cast<size_t>(nextWidth) * nextHeight * 4);
+
+        //尺寸为1的方向上两个采样点重合
+        for (uint32_t y = 0; y < nextHeight; y++)
+        {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            for (uint32_t x = 0; x < nextWidth; x++)
+            {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    uint32_t sum = src[(static_cast<size_t>(y0) * width + x0) * 4 + c]
+                        + src[(static_cast<size_t>(y0) * width + x1) * 4 + c]
+                        + src[(static_cast<size_t>(y1) * width + x0) * 4 + c]
+                        + src[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+                    dst[(static_cast<size_t>(y) * nextWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+
+        levels.push_back(std::move(dst));
+        width = nextWidth;
+        height = nextHeight;
+    }
+    return levels;
+}
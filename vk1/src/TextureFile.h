@@ -0,0 +1,73 @@
+#pragma once
+#include "MeshFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//预先生成好mip链的纹理文件，结构参考KTX2：
+//  文件头 | mip级别表 | 各级别的数据
+//级别0是最精细的一级，数据段按从最粗到最精细的顺序存放，每段的偏移按SECTION_ALIGNMENT对齐，
+//流式加载时先读取的粗级别在文件开头。加载时整个文件被映射到内存，各级别直接从映射拷贝到暂存缓冲。
+//只支持formatTexelBytes列出的非压缩格式，每个纹素texelBytes字节，行之间没有填充。
+class TextureFile
+{
+public:
+    static const uint32_t MAGIC = 0x58544b56; //"VKTX"
+    static const uint32_t VERSION = 1;
+    static const uint32_t SECTION_ALIGNMENT = 64;
+    static const uint32_t MAX_MIP_LEVELS = 16;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t format;     //VkFormat
+        uint32_t texelBytes;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t reserved;
+    };
+
+    struct MipLevel
+    {
+        uint64_t offset;
+        uint64_t bytes;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    //支持的VkFormat每个纹素的字节数，不支持的格式返回0
+    static uint32_t formatTexelBytes(uint32_t format);
+    //宽高为width、height时完整mip链的级别数
+    static uint32_t fullMipCount(uint32_t width, uint32_t height);
+
+    //映射并校验文件，格式不对时抛出异常
+    void open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.data() != nullptr; }
+
+    const Header& getHeader() const { return header; }
+    uint32_t getMipCount() const { return header.mipCount; }
+    const MipLevel& getMip(uint32_t level) const { return mips[level]; }
+    //指向映射内存，close之后失效
+    const void* getMipData(uint32_t level) const { return file.data() + mips[level].offset; }
+
+    //写入文件：先写临时文件再重命名，失败时抛出异常。levels[0]是最精细的一级
+    static void write(const std::string& path, uint32_t format, uint32_t texelBytes, uint32_t width, uint32_t height,
+        const std::vector<std::vector<uint8_t>>& levels);
+    //从RGBA8图像用2x2盒式滤波生成完整的mip链，返回的levels[0]就是输入
+    static std::vector<std::vector<uint8_t>> generateMipsRgba8(const uint8_t* pixels, uint32_t width, uint32_t height);
+
+private:
+    MappedFile file;
+    Header header = {};
+    const MipLevel* mips = nullptr;
+
+    static uint64_t alignSection(uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+};
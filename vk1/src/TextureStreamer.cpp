@@ -0,0 +1,313 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+
+//每帧最多开始这么多字节的上传，至少开始一次，避免一帧里创建太多暂存缓冲
+static const VkDeviceSize MAX_UPLOAD_BYTES_PER_FRAME = 32 * 1024 * 1024;
+
+void TextureStreamer::init(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator& allocator, UploadManager& uploadManager,
+    BindlessDescriptors& bindless, VkDeviceSize budgetBytes, TimelineSemaphore& graphicsTimeline)
+{
+    this->device = device;
+    this->physicalDevice = physicalDevice;
+    this->allocator = &allocator;
+    this->uploadManager = &uploadManager;
+    this->bindless = &bindless;
+    this->graphicsTimeline = &graphicsTimeline;
+    stats = Stats();
+    stats.budgetBytes = budgetBytes;
+
+    //图像的级别0就是驻留的最精细级别，采样器不需要知道缺了哪些级别
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create texture sampler");
+    }
+}
+
+void TextureStreamer::destroy()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    //调用前设备已经空闲
+    for (auto& entry : retired)
+    {
+        destroyResidency(entry.residency);
+    }
+    retired.clear();
+    for (auto& texture : textures)
+    {
+        destroyResidency(texture->pending);
+        destroyResidency(texture->current);
+    }
+    textures.clear();
+
+    vkDestroySampler(device, sampler, nullptr);
+    sampler = VK_NULL_HANDLE;
+    device = VK_NULL_HANDLE;
+}
+
+uint32_t TextureStreamer::load(const std::string& path)
+{
+    auto texture = std::make_unique<Texture>();
+    texture->path = path;
+    texture->file.open(path);
+
+    //文件只保证是支持的格式，设备还要能以最优排布采样并作为拷贝目标
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, static_cast<VkFormat>(texture->file.getHeader().format),
+        &formatProperties);
+    const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    if ((formatProperties.optimalTilingFeatures & required) != required)
+    {
+        throw std::runtime_error("texture format not supported by the device: " + path);
+    }
+
+    //第一个两边都不超过TAIL_SIZE的级别，纹理本身更小时就是级别0
+    uint32_t mipCount = texture->file.getMipCount();
+    texture->tailMip = mipCount - 1;
+    for (uint32_t level = 0; level < mipCount; level++)
+    {
+        const TextureFile::MipLevel& mip = texture->file.getMip(level);
+        if (mip.width <= TAIL_SIZE && mip.height <= TAIL_SIZE)
+        {
+            texture->tailMip = level;
+            break;
+        }
+    }
+    texture->requestedMip = texture->tailMip;
+
+    //尾部不受预算限制
+    beginTransition(*texture, texture->tailMip);
+
+#ifndef NDEBUG
+    const TextureFile::Header& header = texture->file.getHeader();
+    printf("texture: %s, %ux%u, %u mips, %u tail mips always resident\n", path.c_str(), header.width, header.height,
+        mipCount, mipCount - texture->tailMip);
+#endif
+
+    textures.push_back(std::move(texture));
+    return static_cast<uint32_t>(textures.size() - 1);
+}
+
+void TextureStreamer::request(uint32_t texture, uint32_t mipLevel, float priority)
+{
+    Texture& entry = *textures[texture];
+    entry.requestedMip = std::min(mipLevel, entry.tailMip);
+    entry.priority = priority;
+}
+
+void TextureStreamer::update()
+{
+    //上传完成的图像换上去，这一帧录制的指令就使用新句柄；后台批次完成之后图形队列才会取得它的所有权，
+    //并且取得所有权的屏障录制在这一帧或者更早的帧中
+    for (auto& texture : textures)
+    {
+        Residency& pending = texture->pending;
+        if (pending.image == VK_NULL_HANDLE || !uploadManager->isComplete(pending.batch))
+        {
+            continue;
+        }
+
+        pending.handle = bindless->addImage(pending.view, sampler);
+        if (texture->current.image != VK_NULL_HANDLE)
+        {
+            //之前提交的指令缓冲还可能引用旧句柄，之后录制的都使用新句柄
+            retired.push_back({ texture->current, graphicsTimeline->getPendingValue() });
+        }
+#ifndef NDEBUG
+        printf("texture: %s mip %u resident (%.1f / %.1f MB)\n", texture->path.c_str(), pending.topMip,
+            stats.residentBytes / (1024.0 * 1024.0), stats.budgetBytes / (1024.0 * 1024.0));
+#endif
+        texture->current = pending;
+        texture->pending = Residency();
+        stats.transitions++;
+    }
+
+    auto end = std::remove_if(retired.begin(), retired.end(), [this](Retired& entry) {
+        if (!graphicsTimeline->isReached(entry.retireValue))
+        {
+            return false;
+        }
+        destroyResidency(entry.residency);
+        return true;
+    });
+    retired.erase(end, retired.end());
+
+    std::vector<uint32_t> targets = planResidency();
+    VkDeviceSize startedBytes = 0;
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        Texture& texture = *textures[i];
+        uint32_t currentMip = texture.current.topMip;
+        if (texture.pending.image != VK_NULL_HANDLE || texture.current.image == VK_NULL_HANDLE || targets[i] == currentMip)
+        {
+            continue;
+        }
+
+        //变精细时每次只增加一级，粗的级别先可见；变粗时直接退到目标级别
+        uint32_t topMip = targets[i] < currentMip ? currentMip - 1 : targets[i];
+        VkDeviceSize bytes = chainBytes(texture, topMip);
+        if (topMip < currentMip)
+        {
+            //替换期间新旧图像同时存在
+            if (stats.residentBytes + bytes > stats.budgetBytes)
+            {
+                continue;
+            }
+            if (startedBytes > 0 && startedBytes + bytes > MAX_UPLOAD_BYTES_PER_FRAME)
+            {
+                continue;
+            }
+        }
+
+        beginTransition(texture, topMip);
+        startedBytes += bytes;
+    }
+}
+
+VkDeviceSize TextureStreamer::chainBytes(const Texture& texture, uint32_t topMip)
+{
+    VkDeviceSize bytes = 0;
+    for (uint32_t level = topMip; level < texture.file.getMipCount(); level++)
+    {
+        bytes += texture.file.getMip(level).bytes;
+    }
+    return bytes;
+}
+
+std::vector<uint32_t> TextureStreamer::planResidency() const
+{
+    //尾部一直驻留，剩下的预算按优先级从高到低分配，每个纹理最多分到它请求的级别
+    std::vector<uint32_t> targets(textures.size());
+    VkDeviceSize used = 0;
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        targets[i] = textures[i]->tailMip;
+        used += chainBytes(*textures[i], targets[i]);
+    }
+
+    std::vector<size_t> order(textures.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return textures[a]->priority > textures[b]->priority;
+    });
+
+    for (size_t i : order)
+    {
+        const Texture& texture = *textures[i];
+        while (targets[i] > texture.requestedMip)
+        {
+            VkDeviceSize extra = texture.file.getMip(targets[i] - 1).bytes;
+            if (used + extra > stats.budgetBytes)
+            {
+                break;
+            }
+            used += extra;
+            targets[i]--;
+        }
+    }
+    return targets;
+}
+
+void TextureStreamer::beginTransition(Texture& texture, uint32_t topMip)
+{
+    const TextureFile::Header& header = texture.file.getHeader();
+    const TextureFile::MipLevel& top = texture.file.getMip(topMip);
+    uint32_t levelCount = header.mipCount - topMip;
+
+    Residency residency;
+    residency.topMip = topMip;
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = static_cast<VkFormat>(header.format);
+    imageInfo.extent = { top.width, top.height, 1 };
+    imageInfo.mipLevels = levelCount;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &residency.image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create texture image for " + texture.path);
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, residency.image, &memRequirements);
+    residency.allocation = allocator->allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        AllocationType::Optimal);
+    vkBindImageMemory(device, residency.image, residency.allocation.memory, residency.allocation.offset);
+    residency.bytes = memRequirements.size;
+    stats.residentBytes += residency.bytes;
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = residency.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = imageInfo.format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = levelCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device, &viewInfo, nullptr, &residency.view) != VK_SUCCESS)
+    {
+        destroyResidency(residency);
+        throw std::runtime_error("failed to create texture image view for " + texture.path);
+    }
+
+    //文件中的级别topMip是新图像的级别0
+    for (uint32_t level = topMip; level < header.mipCount; level++)
+    {
+        const TextureFile::MipLevel& mip = texture.file.getMip(level);
+        uploadManager->uploadImage(residency.image, level - topMip, { mip.width, mip.height, 1 },
+            texture.file.getMipData(level), mip.bytes, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        stats.streamedBytes += mip.bytes;
+    }
+    residency.batch = uploadManager->flush(true);
+
+    texture.pending = residency;
+}
+
+void TextureStreamer::destroyResidency(Residency& residency)
+{
+    if (residency.image == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    if (residency.handle != BindlessDescriptors::INVALID_HANDLE)
+    {
+        bindless->removeImage(residency.handle);
+    }
+    vkDestroyImageView(device, residency.view, nullptr);
+    vkDestroyImage(device, residency.image, nullptr);
+    allocator->free(residency.allocation);
+    stats.residentBytes -= residency.bytes;
+    residency = Residency();
+}
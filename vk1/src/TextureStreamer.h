@@ -0,0 +1,106 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+#include "UploadManager.h"
+#include "BindlessDescriptors.h"
+#include "TextureFile.h"
+#include "TimelineSemaphore.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//按显存预算流式加载mip级别的纹理。
+//纹理文件一直保持映射，每个纹理在显存中只保留从residentMip到最粗一级的mip链：
+//尺寸不超过TAIL_SIZE的尾部级别在加载时上传并一直驻留，更精细的级别按请求每次增加一级，从粗到细。
+//没有稀疏绑定时图像的级别数在创建时就固定了，所以驻留级别变化时创建一个新的图像，
+//把新的mip链从映射的文件整体上传(已经驻留的较小级别只占新增级别的三分之一左右)，
+//上传在后台批次中执行，完成后换上新图像并分配新的无绑定句柄；旧图像和句柄等到图形队列的时间线越过替换时最后一次提交的值才释放。
+//显存不够时，请求级别比驻留级别粗的纹理先退回到请求的级别，再按优先级把预算分给其他纹理。
+class TextureStreamer
+{
+public:
+    //尺寸不超过这个值的级别一直驻留
+    static const uint32_t TAIL_SIZE = 128;
+
+    struct Stats
+    {
+        VkDeviceSize residentBytes = 0;  //所有纹理图像(包括正在替换的新旧图像)占用的显存
+        VkDeviceSize budgetBytes = 0;
+        VkDeviceSize streamedBytes = 0;  //累计上传的字节数
+        uint32_t transitions = 0;        //累计完成的驻留级别变化次数
+    };
+
+    //graphicsTimeline是使用纹理的图形队列的时间线
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, MemoryAllocator& allocator, UploadManager& uploadManager,
+        BindlessDescriptors& bindless, VkDeviceSize budgetBytes, TimelineSemaphore& graphicsTimeline);
+    void destroy();
+
+    //映射纹理文件并开始上传尾部级别，返回纹理编号。文件无效或者设备不能采样这种格式时抛出异常
+    uint32_t load(const std::string& path);
+
+    //希望驻留到的最精细级别，priority越大越先分到预算。每帧根据画面中的尺寸更新
+    void request(uint32_t texture, uint32_t mipLevel, float priority);
+
+    //每帧录制指令之前调用：换上已经上传完成的图像，释放不再使用的旧图像，按预算开始新的上传
+    void update();
+
+    //着色器中使用的句柄，第一次上传完成之前为INVALID_HANDLE
+    uint32_t getHandle(uint32_t texture) const { return textures[texture]->current.handle; }
+    uint32_t getResidentMip(uint32_t texture) const { return textures[texture]->current.topMip; }
+    uint32_t getWidth(uint32_t texture) const { return textures[texture]->file.getHeader().width; }
+    uint32_t getHeight(uint32_t texture) const { return textures[texture]->file.getHeader().height; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    //一个图像包含从topMip到最粗一级的mip链
+    struct Residency
+    {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        Allocation allocation;
+        uint32_t handle = BindlessDescriptors::INVALID_HANDLE;
+        uint32_t topMip = UINT32_MAX;
+        VkDeviceSize bytes = 0;
+        uint64_t batch = 0;
+    };
+
+    struct Texture
+    {
+        std::string path;
+        TextureFile file;
+        uint32_t tailMip = 0;
+        uint32_t requestedMip = 0;
+        float priority = 0.0f;
+        Residency current;
+        Residency pending; //正在上传的新图像
+    };
+
+    //被替换下来的图像，图形队列的时间线到达retireValue之后释放
+    struct Retired
+    {
+        Residency residency;
+        uint64_t retireValue;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    UploadManager* uploadManager = nullptr;
+    BindlessDescriptors* bindless = nullptr;
+    VkSampler sampler = VK_NULL_HANDLE;
+    TimelineSemaphore* graphicsTimeline = nullptr;
+
+    std::vector<std::unique_ptr<Texture>> textures;
+    std::vector<Retired> retired;
+    Stats stats;
+
+    //从topMip到最粗一级的数据量
+    static VkDeviceSize chainBytes(const Texture& texture, uint32_t topMip);
+    //按预算决定每个纹理这一帧的目标级别
+    std::vector<uint32_t> planResidency() const;
+    void beginTransition(Texture& texture, uint32_t topMip);
+    void destroyResidency(Residency& residency);
+};
@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+    //调用线程算作一个工作线程，只需要额外创建workerCount - 1个
+    for (uint32_t i = 1; i < workerCount; i++)
+    {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::dispatch(uint32_t taskCount, const Task& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        this->taskCount = taskCount;
+        nextTask = 0;
+        busyWorkers = static_cast<uint32_t>(threads.size());
+        generation++;
+    }
+    startCondition.notify_all();
+
+    runTasks(0);
+
+    //等所有工作线程都离开这一批任务，之后task的引用才能失效
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return busyWorkers == 0; });
+    currentTask = nullptr;
+
+    if (firstException)
+    {
+        std::exception_ptr exception = firstException;
+        firstException = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::workerLoop(uint32_t workerIndex)
+{
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+            {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runTasks(workerIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+//从共享的计数器上领取任务，直到这一批全部被领完
+void ThreadPool::runTasks(uint32_t workerIndex)
+{
+    for (;;)
+    {
+        uint32_t taskIndex = nextTask.fetch_add(1);
+        if (taskIndex >= taskCount)
+        {
+            return;
+        }
+
+        try
+        {
+            (*currentTask)(taskIndex, workerIndex);
+        }
+        catch (...)
+        {
+            //记录异常后把剩下的任务都领走，尽快结束这一批
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!firstException)
+            {
+                firstException = std::current_exception();
+            }
+            nextTask = taskCount;
+        }
+    }
+}
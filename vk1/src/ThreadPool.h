@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//固定数量的工作线程，用于把一批相互独立的任务(比如录制多个次级指令缓冲)分摊到多个核心上。
+//dispatch会阻塞到这一批任务全部完成，调用线程本身也作为0号工作线程参与执行，
+//所以workerIndex的范围是[0, getWorkerCount())，可以用来索引每个线程独占的资源(指令池等)。
+//任务中抛出的第一个异常会在dispatch返回前重新抛出。
+class ThreadPool
+{
+public:
+    using Task = std::function<void(uint32_t taskIndex, uint32_t workerIndex)>;
+
+    explicit ThreadPool(uint32_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void dispatch(uint32_t taskCount, const Task& task);
+
+    uint32_t getWorkerCount() const { return static_cast<uint32_t>(threads.size()) + 1; }
+
+private:
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    //当前这一批任务，generation每次dispatch加一，用来唤醒工作线程
+    const Task* currentTask = nullptr;
+    uint32_t taskCount = 0;
+    uint64_t generation = 0;
+    std::atomic<uint32_t> nextTask{ 0 };
+    uint32_t busyWorkers = 0;
+    bool stopping = false;
+    std::exception_ptr firstException;
+
+    void workerLoop(uint32_t workerIndex);
+    void runTasks(uint32_t workerIndex);
+};
@@ -0,0 +1,97 @@
+#include "TimelineSemaphore.h"
+
+#include <limits>
+#include <stdexcept>
+
+bool TimelineSemaphore::isSupported(VkPhysicalDevice physicalDevice)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = requiredFeatures();
+    timelineFeatures.timelineSemaphore = VK_FALSE;
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &timelineFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+    return timelineFeatures.timelineSemaphore == VK_TRUE;
+}
+
+VkPhysicalDeviceTimelineSemaphoreFeatures TimelineSemaphore::requiredFeatures()
+{
+    VkPhysicalDeviceTimelineSemaphoreFeatures features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    features.timelineSemaphore = VK_TRUE;
+    return features;
+}
+
+void TimelineSemaphore::init(VkDevice device)
+{
+    this->device = device;
+    pendingValue = 0;
+    completed = 0;
+
+    VkSemaphoreTypeCreateInfo typeInfo = {};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create timeline semaphore");
+    }
+}
+
+void TimelineSemaphore::destroy()
+{
+    if (semaphore == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDestroySemaphore(device, semaphore, nullptr);
+    semaphore = VK_NULL_HANDLE;
+    device = VK_NULL_HANDLE;
+}
+
+uint64_t TimelineSemaphore::completedValue()
+{
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(device, semaphore, &value) == VK_SUCCESS && value > completed)
+    {
+        completed = value;
+    }
+    return completed;
+}
+
+bool TimelineSemaphore::isReached(uint64_t value)
+{
+    return value <= completed || value <= completedValue();
+}
+
+void TimelineSemaphore::wait(uint64_t value)
+{
+    if (isReached(value))
+    {
+        return;
+    }
+
+    VkSemaphoreWaitInfo waitInfo = {};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &semaphore;
+    waitInfo.pValues = &value;
+
+    if (vkWaitSemaphores(device, &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to wait for timeline semaphore");
+    }
+    completed = value;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+//一个队列上的提交进度。
+//Vulkan 1.2的时间线信号量带有一个单调递增的64位计数，每次提交把它触发到一个更大的值，
+//CPU等待某个值，资源能否复用也只需要比较这次使用的值和已经完成的值，不再需要每帧一个fence，
+//也不需要重置或者回收同步对象。每个队列使用一个，只在提交到这个队列的线程上调用nextValue。
+class TimelineSemaphore
+{
+public:
+    //设备版本至少为1.2并且支持timelineSemaphore特性
+    static bool isSupported(VkPhysicalDevice physicalDevice);
+    //创建逻辑设备时链接到VkPhysicalDeviceFeatures2的pNext，返回值的pNext为空
+    static VkPhysicalDeviceTimelineSemaphoreFeatures requiredFeatures();
+
+    void init(VkDevice device);
+    void destroy();
+
+    VkSemaphore get() const { return semaphore; }
+
+    //下一次提交触发的值，在vkQueueSubmit之前调用，提交必须按取得的顺序进行
+    uint64_t nextValue() { return ++pendingValue; }
+    //最后一次提交触发的值，等到这个值时之前提交的工作都已经完成
+    uint64_t getPendingValue() const { return pendingValue; }
+
+    //已经完成的值，每次调用都会查询
+    uint64_t completedValue();
+    bool isReached(uint64_t value);
+    void wait(uint64_t value);
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    uint64_t pendingValue = 0;
+    //最近一次查询到的完成值，不超过它的值不需要再查询
+    uint64_t completed = 0;
+};
@@ -0,0 +1,79 @@
+#include "UniformRingBuffer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void UniformRingBuffer::create(VkDevice device, MemoryAllocator& allocator, VkDeviceSize alignment,
+    VkDeviceSize frameSize, uint32_t frameCount, VkBufferUsageFlags usage)
+{
+    this->device = device;
+    this->allocator = &allocator;
+    this->alignment = alignment > 0 ? alignment : 1;
+    //每一帧的起始偏移本身也要满足对齐要求
+    this->frameSize = alignUp(frameSize, this->alignment);
+    this->frameCount = frameCount;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = this->frameSize * frameCount;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create uniform ring buffer");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+    //主机一致的内存，写入后不需要flush
+    allocation = allocator.allocate(memRequirements,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, AllocationType::Linear);
+    vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+
+    frameBegin = 0;
+    head = 0;
+}
+
+void UniformRingBuffer::destroy()
+{
+    if (buffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator->free(allocation);
+    buffer = VK_NULL_HANDLE;
+}
+
+void UniformRingBuffer::beginFrame(uint32_t frameIndex)
+{
+    frameBegin = getFrameOffset(frameIndex % frameCount);
+    head = frameBegin;
+}
+
+uint32_t UniformRingBuffer::allocate(VkDeviceSize size)
+{
+    VkDeviceSize offset = alignUp(head, alignment);
+    if (offset + size > frameBegin + frameSize)
+    {
+        throw std::runtime_error("uniform ring buffer overflow");
+    }
+
+    head = offset + size;
+    return static_cast<uint32_t>(offset);
+}
+
+uint32_t UniformRingBuffer::push(const void* data, VkDeviceSize size)
+{
+    uint32_t offset = allocate(size);
+    memcpy(getMapped(offset), data, static_cast<size_t>(size));
+    return offset;
+}
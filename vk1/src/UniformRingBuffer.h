@@ -0,0 +1,47 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+
+#include <cstdint>
+
+//按并行帧切分的环形uniform缓冲：整个缓冲只创建一次并一直保持映射，
+//每个并行帧占用其中固定的一段，帧开始时把这一段的写入位置归零，之后每次写入都按对齐要求向后追加，
+//返回的偏移作为动态uniform缓冲的dynamic offset在绑定描述符集时传入。
+//调用beginFrame之前必须已经等到这一帧上次提交的时间线值，保证GPU不再读取这一段。
+class UniformRingBuffer
+{
+public:
+    void create(VkDevice device, MemoryAllocator& allocator, VkDeviceSize alignment, VkDeviceSize frameSize,
+        uint32_t frameCount, VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    void destroy();
+
+    void beginFrame(uint32_t frameIndex);
+    //写入一段数据，返回它在缓冲中的偏移
+    uint32_t push(const void* data, VkDeviceSize size);
+    //只预留一段空间，返回偏移，之后通过getMapped写入，多个线程可以各自写入预留空间中互不重叠的部分
+    uint32_t allocate(VkDeviceSize size);
+    void* getMapped(uint32_t offset) const { return static_cast<char*>(allocation.mapped) + offset; }
+    //按对齐要求向上取整后的大小，连续存放多个对象时每个对象占用的跨度
+    VkDeviceSize getAlignedSize(VkDeviceSize size) const { return (size + alignment - 1) / alignment * alignment; }
+
+    //某一帧的起始偏移，也是这一帧第一次push返回的偏移
+    uint32_t getFrameOffset(uint32_t frameIndex) const { return static_cast<uint32_t>(frameIndex * frameSize); }
+    VkBuffer getBuffer() const { return buffer; }
+    VkDeviceSize getFrameSize() const { return frameSize; }
+    VkDeviceSize getAlignment() const { return alignment; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    Allocation allocation;
+
+    VkDeviceSize alignment = 1;
+    VkDeviceSize frameSize = 0;
+    uint32_t frameCount = 0;
+
+    //当前帧的区间[frameBegin, frameBegin + frameSize)和下一次写入的位置
+    VkDeviceSize frameBegin = 0;
+    VkDeviceSize head = 0;
+};
@@ -0,0 +1,362 @@
+#include "UploadManager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+void UploadManager::init(VkDevice device, MemoryAllocator& allocator, uint32_t transferFamily, VkQueue transferQueue,
+    TimelineSemaphore& timeline, uint32_t graphicsFamily)
+{
+    this->device = device;
+    this->allocator = &allocator;
+    this->transferFamily = transferFamily;
+    this->transferQueue = transferQueue;
+    this->timeline = &timeline;
+    lastBatchId = 0;
+    this->graphicsFamily = graphicsFamily;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = transferFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upload command pool");
+    }
+}
+
+void UploadManager::destroy()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    //还没提交的拷贝直接丢弃
+    for (auto& copy : pendingCopies)
+    {
+        vkDestroyBuffer(device, copy.staging, nullptr);
+        allocator->free(copy.stagingAllocation);
+    }
+    pendingCopies.clear();
+    for (auto& copy : pendingImageCopies)
+    {
+        vkDestroyBuffer(device, copy.staging, nullptr);
+        allocator->free(copy.stagingAllocation);
+    }
+    pendingImageCopies.clear();
+
+    timeline->wait(lastBatchId);
+    for (auto& batch : batches)
+    {
+        releaseBatch(batch);
+    }
+    batches.clear();
+
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    device = VK_NULL_HANDLE;
+}
+
+//暂存缓冲从分配器的主机可见内存块中切分，创建代价很小
+void UploadManager::createStaging(const void* data, VkDeviceSize size, VkBuffer& staging, Allocation& stagingAllocation)
+{
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &staging) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create staging buffer");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, staging, &memRequirements);
+    stagingAllocation = allocator->allocate(memRequirements,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, AllocationType::Linear);
+    vkBindBufferMemory(device, staging, stagingAllocation.memory, stagingAllocation.offset);
+
+    memcpy(stagingAllocation.mapped, data, static_cast<size_t>(size));
+}
+
+void UploadManager::uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    PendingCopy copy = {};
+    createStaging(data, size, copy.staging, copy.stagingAllocation);
+
+    copy.dst = dst;
+    copy.region.srcOffset = 0;
+    copy.region.dstOffset = dstOffset;
+    copy.region.size = size;
+    copy.dstStage = dstStage;
+    copy.dstAccess = dstAccess;
+    pendingCopies.push_back(copy);
+}
+
+void UploadManager::uploadImage(VkImage dst, uint32_t mipLevel, VkExtent3D extent, const void* data, VkDeviceSize size,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    PendingImageCopy copy = {};
+    createStaging(data, size, copy.staging, copy.stagingAllocation);
+
+    copy.dst = dst;
+    copy.region.bufferOffset = 0;
+    copy.region.bufferRowLength = 0; //紧密排列
+    copy.region.bufferImageHeight = 0;
+    copy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.region.imageSubresource.mipLevel = mipLevel;
+    copy.region.imageSubresource.baseArrayLayer = 0;
+    copy.region.imageSubresource.layerCount = 1;
+    copy.region.imageOffset = { 0, 0, 0 };
+    copy.region.imageExtent = extent;
+    copy.dstStage = dstStage;
+    copy.dstAccess = dstAccess;
+    pendingImageCopies.push_back(copy);
+}
+
+uint64_t UploadManager::flush(bool background)
+{
+    if (pendingCopies.empty() && pendingImageCopies.empty())
+    {
+        return lastBatchId;
+    }
+
+    Batch batch;
+    batch.background = background;
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate upload command buffer");
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+    std::vector<VkBufferMemoryBarrier> releaseBarriers;
+    VkPipelineStageFlags sameQueueDstStages = 0;
+
+    for (auto& copy : pendingCopies)
+    {
+        vkCmdCopyBuffer(batch.commandBuffer, copy.staging, copy.dst, 1, &copy.region);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.buffer = copy.dst;
+        barrier.offset = copy.region.dstOffset;
+        barrier.size = copy.region.size;
+
+        if (usesOwnershipTransfer())
+        {
+            //release屏障的dstAccessMask被忽略，可见性由图形队列上的acquire屏障保证
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            releaseBarriers.push_back(barrier);
+
+            VkBufferMemoryBarrier acquire = barrier;
+            acquire.srcAccessMask = 0;
+            acquire.dstAccessMask = copy.dstAccess;
+            batch.acquireBarriers.push_back(acquire);
+            batch.acquireStages |= copy.dstStage;
+        }
+        else
+        {
+            //同一个队列上后面提交的指令按提交顺序受这个屏障约束
+            barrier.dstAccessMask = copy.dstAccess;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            releaseBarriers.push_back(barrier);
+            sameQueueDstStages |= copy.dstStage;
+        }
+
+        batch.stagingBuffers.push_back(copy.staging);
+        batch.stagingAllocations.push_back(copy.stagingAllocation);
+    }
+    pendingCopies.clear();
+
+    //图像的每个级别先转换到可以写入的布局，原来的内容不需要保留
+    std::vector<VkImageMemoryBarrier> transferBarriers;
+    for (auto& copy : pendingImageCopies)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = copy.dst;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, copy.region.imageSubresource.mipLevel, 1, 0, 1 };
+        transferBarriers.push_back(barrier);
+    }
+    if (!transferBarriers.empty())
+    {
+        vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, static_cast<uint32_t>(transferBarriers.size()), transferBarriers.data());
+    }
+
+    std::vector<VkImageMemoryBarrier> releaseImageBarriers;
+    for (auto& copy : pendingImageCopies)
+    {
+        vkCmdCopyBufferToImage(batch.commandBuffer, copy.staging, copy.dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &copy.region);
+
+        //布局转换在release和acquire屏障中各写一次，只执行一次
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.image = copy.dst;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, copy.region.imageSubresource.mipLevel, 1, 0, 1 };
+
+        if (usesOwnershipTransfer())
+        {
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            releaseImageBarriers.push_back(barrier);
+
+            VkImageMemoryBarrier acquire = barrier;
+            acquire.srcAccessMask = 0;
+            acquire.dstAccessMask = copy.dstAccess;
+            batch.acquireImageBarriers.push_back(acquire);
+            batch.acquireStages |= copy.dstStage;
+        }
+        else
+        {
+            barrier.dstAccessMask = copy.dstAccess;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            releaseImageBarriers.push_back(barrier);
+            sameQueueDstStages |= copy.dstStage;
+        }
+
+        batch.stagingBuffers.push_back(copy.staging);
+        batch.stagingAllocations.push_back(copy.stagingAllocation);
+    }
+    pendingImageCopies.clear();
+
+    VkPipelineStageFlags dstStages = usesOwnershipTransfer()
+        ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) : sameQueueDstStages;
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0,
+        0, nullptr, static_cast<uint32_t>(releaseBarriers.size()), releaseBarriers.data(),
+        static_cast<uint32_t>(releaseImageBarriers.size()), releaseImageBarriers.data());
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    //不转移所有权时和图形提交在同一个队列上，按提交顺序执行，不需要等待
+    batch.acquired = !usesOwnershipTransfer();
+
+    //取值和提交之间没有其他提交，时间线上的值按提交顺序递增
+    batch.id = timeline->nextValue();
+    VkSemaphore signalSemaphore = timeline->get();
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &batch.id;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &signalSemaphore;
+
+    if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit upload batch");
+    }
+
+    lastBatchId = batch.id;
+    batches.push_back(std::move(batch));
+    return lastBatchId;
+}
+
+bool UploadManager::isComplete(uint64_t batchId)
+{
+    return timeline->isReached(batchId);
+}
+
+void UploadManager::wait(uint64_t batchId)
+{
+    timeline->wait(batchId);
+}
+
+void UploadManager::takePendingAcquire(std::vector<VkBufferMemoryBarrier>& barriers,
+    std::vector<VkImageMemoryBarrier>& imageBarriers, VkPipelineStageFlags& dstStages,
+    std::vector<VkSemaphore>& waitSemaphores, std::vector<uint64_t>& waitValues,
+    std::vector<VkPipelineStageFlags>& waitStages)
+{
+    uint64_t waitValue = 0;
+    VkPipelineStageFlags waitStage = 0;
+    for (auto& batch : batches)
+    {
+        if (batch.acquired)
+        {
+            continue;
+        }
+        //后台批次传输完成之后再交给图形队列，这时等待时间线不会停顿
+        if (batch.background && !timeline->isReached(batch.id))
+        {
+            continue;
+        }
+
+        barriers.insert(barriers.end(), batch.acquireBarriers.begin(), batch.acquireBarriers.end());
+        imageBarriers.insert(imageBarriers.end(), batch.acquireImageBarriers.begin(), batch.acquireImageBarriers.end());
+        dstStages |= batch.acquireStages;
+        waitValue = std::max(waitValue, batch.id);
+        waitStage |= batch.acquireStages;
+        batch.acquired = true;
+    }
+
+    if (waitValue != 0)
+    {
+        waitSemaphores.push_back(timeline->get());
+        waitValues.push_back(waitValue);
+        waitStages.push_back(waitStage);
+    }
+}
+
+//传输完成后暂存缓冲就可以释放，acquire屏障要保留到图形队列取走为止
+bool UploadManager::isBatchFinished(Batch& batch)
+{
+    return batch.acquired && timeline->isReached(batch.id);
+}
+
+void UploadManager::collect()
+{
+    while (!batches.empty() && isBatchFinished(batches.front()))
+    {
+        releaseBatch(batches.front());
+        batches.pop_front();
+    }
+}
+
+void UploadManager::releaseBatch(Batch& batch)
+{
+    for (size_t i = 0; i < batch.stagingBuffers.size(); i++)
+    {
+        vkDestroyBuffer(device, batch.stagingBuffers[i], nullptr);
+        allocator->free(batch.stagingAllocations[i]);
+    }
+    batch.stagingBuffers.clear();
+    batch.stagingAllocations.clear();
+
+    vkFreeCommandBuffers(device, commandPool, 1, &batch.commandBuffer);
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include "MemoryAllocator.h"
+#include "TimelineSemaphore.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+//批量上传数据到设备本地缓冲。
+//uploadBuffer只把数据写入暂存缓冲并记下拷贝，flush把目前积累的所有拷贝录制到一个指令缓冲，
+//一次提交到传输队列，不会等待队列空闲，上传可以和渲染重叠。
+//每一批把传输队列的时间线信号量触发到一个新的值，这个值就是批次编号，完成情况只需要和已经完成的值比较。
+//传输队列族和图形队列族不同时，缓冲是EXCLUSIVE共享模式，需要转移队列族所有权：
+//传输队列上录制release屏障，图形队列在使用前通过takePendingAcquire取得对应的acquire屏障和需要等待的时间线值。
+//图像按mip级别上传，拷贝前从UNDEFINED转换到TRANSFER_DST_OPTIMAL，之后转换到SHADER_READ_ONLY_OPTIMAL，
+//使用所有权转移时这个布局转换包含在release/acquire屏障中。
+//后台批次(flush(true))的acquire要等传输完成之后才交给图形队列，图形提交不会因为等待它而停顿。
+//不是线程安全的，只在主线程上使用。
+class UploadManager
+{
+public:
+    //timeline是传输队列的时间线，传输队列族和图形队列族相同时就是图形队列的时间线
+    void init(VkDevice device, MemoryAllocator& allocator, uint32_t transferFamily, VkQueue transferQueue,
+        TimelineSemaphore& timeline, uint32_t graphicsFamily);
+    void destroy();
+
+    //把数据拷贝到dst的dstOffset处，dstStage/dstAccess是图形队列之后使用这个缓冲的阶段和访问方式
+    void uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+    //把一个mip级别的数据拷贝到图像，这个级别之前的内容被丢弃，data是紧密排列的纹素
+    void uploadImage(VkImage dst, uint32_t mipLevel, VkExtent3D extent, const void* data, VkDeviceSize size,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+    //提交积累的拷贝，返回这一批的编号，没有需要提交的拷贝时返回上一批的编号。
+    //background为true时图形队列只在这一批完成后才取得它的数据，用于不急着使用的流式数据
+    uint64_t flush(bool background = false);
+    bool isComplete(uint64_t batchId);
+    void wait(uint64_t batchId);
+    //回收已经完成的批次的暂存缓冲和指令缓冲
+    void collect();
+
+    //图形队列录制下一帧之前调用：把还没被acquire的批次的acquire屏障追加到barriers，
+    //需要等待的时间线信号量、等待的值和等待阶段追加到waitSemaphores/waitValues/waitStages，
+    //时间线上的值是单调的，多个批次只需要等待其中最大的一个
+    void takePendingAcquire(std::vector<VkBufferMemoryBarrier>& barriers, std::vector<VkImageMemoryBarrier>& imageBarriers,
+        VkPipelineStageFlags& dstStages, std::vector<VkSemaphore>& waitSemaphores, std::vector<uint64_t>& waitValues,
+        std::vector<VkPipelineStageFlags>& waitStages);
+
+    bool usesOwnershipTransfer() const { return transferFamily != graphicsFamily; }
+
+private:
+    struct PendingCopy
+    {
+        VkBuffer staging;
+        Allocation stagingAllocation;
+        VkBuffer dst;
+        VkBufferCopy region;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags dstAccess;
+    };
+
+    struct PendingImageCopy
+    {
+        VkBuffer staging;
+        Allocation stagingAllocation;
+        VkImage dst;
+        VkBufferImageCopy region;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags dstAccess;
+    };
+
+    struct Batch
+    {
+        //提交时触发的时间线值
+        uint64_t id = 0;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        std::vector<VkBuffer> stagingBuffers;
+        std::vector<Allocation> stagingAllocations;
+        //图形队列需要录制的acquire屏障
+        std::vector<VkBufferMemoryBarrier> acquireBarriers;
+        std::vector<VkImageMemoryBarrier> acquireImageBarriers;
+        VkPipelineStageFlags acquireStages = 0;
+        bool acquired = false;
+        bool background = false;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    uint32_t transferFamily = 0;
+    uint32_t graphicsFamily = 0;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    TimelineSemaphore* timeline = nullptr;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+
+    std::vector<PendingCopy> pendingCopies;
+    std::vector<PendingImageCopy> pendingImageCopies;
+    std::deque<Batch> batches;
+    //时间线和图形队列共用时批次编号不连续，记下最后一批
+    uint64_t lastBatchId = 0;
+
+    void createStaging(const void* data, VkDeviceSize size, VkBuffer& staging, Allocation& stagingAllocation);
+    bool isBatchFinished(Batch& batch);
+    void releaseBatch(Batch& batch);
+};
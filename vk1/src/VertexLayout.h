@@ -0,0 +1,186 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+//顶点布局在编译期从顶点类型的成员生成，不再手写每个属性的格式和偏移。
+//顶点类型提供一个constexpr的attributes()，用VERTEX_ATTRIBUTE列出参与顶点输入的成员和location，例如：
+//  static constexpr auto attributes() {
+//      return makeVertexAttributes(VERTEX_ATTRIBUTE(Vertex, pos, 0), VERTEX_ATTRIBUTE(Vertex, color, 1));
+//  }
+//成员的C++类型通过VertexAttributeType决定VkFormat，矩阵按列占用连续的location。
+
+//量化的属性类型，着色器中读到的都是浮点数，SNORM映射到[-1, 1]，UNORM映射到[0, 1]
+struct Snorm16x2
+{
+    int16_t x, y;
+};
+
+struct Snorm16x4
+{
+    int16_t x, y, z, w;
+};
+
+struct Unorm8x4
+{
+    uint8_t x, y, z, w;
+};
+
+//八面体编码的单位法线，两个分量都是SNORM16，用unpackOctahedral还原。
+//现在的顶点格式没有法线，还没有着色器读取它；着色器中解码时要和unpackOctahedral做同样的计算
+struct OctahedralNormal
+{
+    int16_t x, y;
+};
+
+//C++类型对应的顶点属性格式，columns是占用的location数量
+template<typename T> struct VertexAttributeType;
+
+template<> struct VertexAttributeType<float> { static constexpr VkFormat format = VK_FORMAT_R32_SFLOAT; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<glm::vec2> { static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<glm::vec3> { static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<glm::vec4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<glm::mat4> { static constexpr VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT; static constexpr uint32_t columns = 4; };
+template<> struct VertexAttributeType<Snorm16x2> { static constexpr VkFormat format = VK_FORMAT_R16G16_SNORM; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<Snorm16x4> { static constexpr VkFormat format = VK_FORMAT_R16G16B16A16_SNORM; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<Unorm8x4> { static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM; static constexpr uint32_t columns = 1; };
+template<> struct VertexAttributeType<OctahedralNormal> { static constexpr VkFormat format = VK_FORMAT_R16G16_SNORM; static constexpr uint32_t columns = 1; };
+
+//一个成员的描述，矩阵展开成columns个属性，每列相隔columnSize字节
+struct VertexAttribute
+{
+    uint32_t location;
+    VkFormat format;
+    uint32_t offset;
+    uint32_t columns;
+    uint32_t columnSize;
+};
+
+#define VERTEX_ATTRIBUTE(VertexType, member, location) \
+    VertexAttribute{ (location), VertexAttributeType<decltype(VertexType::member)>::format, \
+        static_cast<uint32_t>(offsetof(VertexType, member)), VertexAttributeType<decltype(VertexType::member)>::columns, \
+        static_cast<uint32_t>(sizeof(VertexType::member) / VertexAttributeType<decltype(VertexType::member)>::columns) }
+
+template<typename... Attributes>
+constexpr std::array<VertexAttribute, sizeof...(Attributes)> makeVertexAttributes(Attributes... attributes)
+{
+    return { attributes... };
+}
+
+//展开矩阵之后的属性数量
+template<size_t N>
+constexpr uint32_t countVertexAttributes(const std::array<VertexAttribute, N>& members)
+{
+    uint32_t count = 0;
+    for (const auto& member : members)
+    {
+        count += member.columns;
+    }
+    return count;
+}
+
+template<size_t N>
+constexpr bool vertexAttributesFit(const std::array<VertexAttribute, N>& members, size_t stride)
+{
+    for (const auto& member : members)
+    {
+        if (member.offset + member.columns * member.columnSize > stride)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename V>
+class VertexLayout
+{
+public:
+    static constexpr auto members = V::attributes();
+    static constexpr uint32_t attributeCount = countVertexAttributes(members);
+    static_assert(vertexAttributesFit(members, sizeof(V)), "vertex attribute outside of the vertex");
+
+    static VkVertexInputBindingDescription bindingDescription(uint32_t binding,
+        VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX)
+    {
+        VkVertexInputBindingDescription description = {};
+        description.binding = binding;
+        description.stride = sizeof(V);
+        description.inputRate = inputRate;
+        return description;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, attributeCount> attributeDescriptions(uint32_t binding)
+    {
+        std::array<VkVertexInputAttributeDescription, attributeCount> descriptions = {};
+        uint32_t n = 0;
+        for (const auto& member : members)
+        {
+            for (uint32_t column = 0; column < member.columns; column++, n++)
+            {
+                descriptions[n].binding = binding;
+                descriptions[n].location = member.location + column;
+                descriptions[n].format = member.format;
+                descriptions[n].offset = member.offset + member.columnSize * column;
+            }
+        }
+        return descriptions;
+    }
+};
+
+//CPU上的打包函数，超出范围的值被截断
+inline int16_t packSnorm16(float value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+inline uint8_t packUnorm8(float value)
+{
+    return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+inline Snorm16x2 packSnorm16x2(glm::vec2 value)
+{
+    return { packSnorm16(value.x), packSnorm16(value.y) };
+}
+
+inline Unorm8x4 packUnorm8x4(glm::vec4 value)
+{
+    return { packUnorm8(value.x), packUnorm8(value.y), packUnorm8(value.z), packUnorm8(value.w) };
+}
+
+//把单位球投影到八面体|x|+|y|+|z|=1上，下半球沿对角线折到上半球，得到[-1, 1]^2内的两个分量
+inline OctahedralNormal packOctahedral(glm::vec3 normal)
+{
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    float x = sum > 0.0f ? normal.x / sum : 0.0f;
+    float y = sum > 0.0f ? normal.y / sum : 0.0f;
+    if (normal.z < 0.0f)
+    {
+        float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    return { packSnorm16(x), packSnorm16(y) };
+}
+
+inline glm::vec3 unpackOctahedral(OctahedralNormal packed)
+{
+    float x = packed.x / 32767.0f;
+    float y = packed.y / 32767.0f;
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f)
+    {
+        float unfoldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float unfoldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    return glm::normalize(glm::vec3(x, y, z));
+}